@@ -0,0 +1,137 @@
+//===- Common/Arena.hpp ---------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A monotonic bump allocator. Memory comes from an initial buffer,
+//  then from a `PageProvider`. Allocations are freed in bulk, either
+//  by rewinding to a `mark()` or with `reset()`.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "Fundamental.hpp"
+#include "Limits.hpp"
+#include "PageProvider.hpp"
+#include "PtrRange.hpp"
+
+namespace hc::common {
+  /// The header at the start of each arena chunk.
+  struct ArenaChunk {
+    u8* data() { return reinterpret_cast<u8*>(this + 1); }
+    u8* end() { return this->data() + size; }
+  public:
+    ArenaChunk* next = nullptr;
+    /// The usable bytes after the header.
+    usize size = 0;
+    /// The block from the `PageProvider`, or empty if not owned.
+    AddrRange block = AddrRange::New();
+  };
+
+  struct [[gsl::Owner]] Arena {
+    /// The minimum size requested from the `PageProvider`.
+    static constexpr usize minChunkSize = 0x10000;
+
+    /// A position to rewind to.
+    struct Mark {
+      ArenaChunk* chunk = nullptr;
+      usize offset = 0;
+    };
+
+  public:
+    constexpr Arena() = default;
+    /// @param initial Used before requesting pages, may be empty.
+    Arena(AddrRange initial, PageProvider pages = {});
+    HC_MARK_DELETED(Arena);
+    /// Releases every chunk from the `PageProvider`.
+    ~Arena();
+
+    /// @return An aligned block of `size` bytes, or `nullptr`.
+    [[nodiscard]] __always_inline void* allocate(usize size, usize align) {
+      __hc_invariant(align != 0 && (align & (align - 1)) == 0);
+      if __expect_true(__curr != nullptr) {
+        const uptr base = uptr(__curr->data());
+        const uptr P = (base + __offset + (align - 1)) & ~uptr(align - 1);
+        // Compared as offsets, so a huge `size` can't wrap past the end.
+        const usize start = P - base;
+        const usize room = __curr->size;
+        if __expect_true(start <= room && size <= room - start) {
+          this->__offset = start + size;
+          return reinterpret_cast<void*>(P);
+        }
+      }
+      return this->allocateSlow(size, align);
+    }
+
+    /// @return Uninitialized storage for `n` objects of type `T`,
+    /// or an empty range on failure.
+    template <typename T>
+    [[nodiscard]] PtrRange<T> allocate(usize n) {
+      if __expect_false(n > Max<usize> / sizeof(T))
+        return PtrRange<T>::New();
+      void* P = this->allocate(n * sizeof(T), alignof(T));
+      if __expect_false(!P)
+        return PtrRange<T>::New();
+      return PtrRange<T>::New(static_cast<T*>(P), n);
+    }
+
+    /// @return The current position.
+    Mark mark() const {
+      return {__curr, __offset};
+    }
+
+    /// Frees everything allocated after `M`. Chunks are kept for reuse.
+    void rewindTo(Mark M) {
+      if __expect_false(M.chunk == nullptr) {
+        this->reset();
+        return;
+      }
+      this->__curr = M.chunk;
+      this->__offset = M.offset;
+    }
+
+    /// Frees everything. Chunks are kept for reuse.
+    void reset() {
+      this->__curr = __head;
+      this->__offset = 0;
+    }
+
+    /// Adds a chunk to allocate from.
+    /// @return `false` if the block is too small to hold a header.
+    bool addChunk(AddrRange block, bool owned = false);
+
+  private:
+    void* allocateSlow(usize size, usize align);
+
+  private:
+    ArenaChunk* __head = nullptr;
+    ArenaChunk* __tail = nullptr;
+    ArenaChunk* __curr = nullptr;
+    usize __offset = 0;
+    PageProvider __pages {};
+  };
+
+  /// Rewinds the arena when leaving the scope.
+  struct [[gsl::Pointer]] ArenaScope {
+    ArenaScope(Arena& A) : __arena(A), __mark(A.mark()) {}
+    HC_MARK_DELETED(ArenaScope);
+    ~ArenaScope() { __arena.rewindTo(__mark); }
+  public:
+    Arena& __arena;
+    Arena::Mark __mark;
+  };
+} // namespace hc::common
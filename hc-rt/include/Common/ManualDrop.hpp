@@ -35,7 +35,7 @@ private:
   using BaseType::ctor;
 public:
   constexpr ManualDrop(auto&&...args) : BaseType() {
-    (void) BaseType::ctor(FWD(args)...);
+    (void) BaseType::ctor(__hc_fwd(args)...);
   }
 
   inline void drop() {
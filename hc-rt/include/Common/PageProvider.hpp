@@ -0,0 +1,56 @@
+//===- Common/PageProvider.hpp --------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  The interface allocators use to get large blocks of memory,
+//  usually whole pages from the OS.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "Fundamental.hpp"
+#include "PtrRange.hpp"
+
+namespace hc::common {
+  struct PageProvider {
+    /// Gets a block of at least `min_size` bytes.
+    /// @return The block, or an empty range on failure.
+    using AllocFn = AddrRange(*)(usize min_size);
+    /// Returns a block from `AllocFn`.
+    using ReleaseFn = void(*)(AddrRange pages);
+  public:
+    [[nodiscard]] AddrRange allocate(usize min_size) const {
+      if __expect_false(!__alloc)
+        return AddrRange::New();
+      return __alloc(min_size);
+    }
+
+    void release(AddrRange pages) const {
+      if (__release && pages.data())
+        __release(pages);
+    }
+
+    constexpr bool isValid() const {
+      return __alloc != nullptr;
+    }
+
+  public:
+    AllocFn __alloc = nullptr;
+    ReleaseFn __release = nullptr;
+  };
+} // namespace hc::common
@@ -190,6 +190,14 @@ using __hc_tyident_ = T;
 # define _HC_MULTITHREADED 0
 #endif
 
+#ifndef _HC_RUNTIME_DISPATCH
+# define _HC_RUNTIME_DISPATCH 0
+#endif
+
+#ifndef _HC_TUNED_DISPATCH
+# define _HC_TUNED_DISPATCH 0
+#endif
+
 #if !_HC_MULTITHREADED && (RT_MAX_THREADS != 0)
 # undef  RT_MAX_THREADS
 # define RT_MAX_THREADS 0
@@ -0,0 +1,132 @@
+//===- Common/Scratch.hpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A per-thread LIFO scratch region. Temporary buffers are taken from
+//  here instead of the stack, so large sizes don't need page probes.
+//  If the region runs out, the macros fall back to `__dynalloc`.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "DynAlloc.hpp"
+
+#ifndef RT_SCRATCH_SIZE
+# define RT_SCRATCH_SIZE 0x10000
+#endif
+
+/// Like `$dynalloc`, but declares `name` in the current scope.
+/// The memory is valid until the end of the scope.
+#define $scratch(name, sz, ty...) \
+  ::hc::common::ScratchScope<ty> name##U__(sz); \
+  auto name = name##U__.isValid() ? name##U__.get() \
+    : __dynalloc(name##U__.requested(), ty)
+
+/// Like `$zdynalloc`, but declares `name` in the current scope.
+#define $zscratch(name, sz, ty...) \
+  $scratch(name, sz, ty); \
+  (void) name.zeroMemory()
+
+/// Like `$to_wstr_sz`, but declares `name` in the current scope.
+#define $scratch_wstr_sz(name, S, size) \
+  $scratch(name, (size) + 1, wchar_t); \
+  ::hc::common::__widen_into(name, S)
+
+#define $scratch_wstr(name, S) \
+  $scratch_wstr_sz(name, S, __builtin_strlen(S))
+
+namespace hc::common {
+  /// A bump region which is freed in LIFO order.
+  struct ScratchStack {
+    static constexpr usize defaultSize = RT_SCRATCH_SIZE;
+  public:
+    /// @return The scratch stack for the current thread.
+    static ScratchStack& Local();
+
+    /// @return An aligned block of `size` bytes, or `nullptr`.
+    [[nodiscard]] __always_inline void* push(usize size, usize align) {
+      const uptr base = uptr(__base);
+      const uptr P = (base + __top + (align - 1)) & ~uptr(align - 1);
+      if __expect_false(!__base || size > (base + __size) - P)
+        return nullptr;
+      this->__top = (P + size) - base;
+      return reinterpret_cast<void*>(P);
+    }
+
+    usize mark() const { return __top; }
+
+    void rewindTo(usize M) {
+      __hc_invariant(M <= __top);
+      this->__top = M;
+    }
+
+    usize remaining() const { return __size - __top; }
+
+  public:
+    u8* __base = nullptr;
+    usize __size = 0;
+    usize __top = 0;
+  };
+
+  /// Takes an allocation from the scratch stack,
+  /// and rewinds it at the end of the scope.
+  template <typename T>
+  struct [[gsl::Owner]] ScratchScope {
+    static_assert(__is_trivial_alloc<T>,
+      "Scratch allocations are never constructed or destroyed.");
+    using AllocType = DynAllocation<T>;
+  public:
+    ScratchScope(usize n) :
+     __stack(ScratchStack::Local()),
+     __mark(__stack.mark()),
+     __alloc(ScratchScope::Make(__stack, n)),
+     __requested(n) {}
+
+    HC_MARK_DELETED(ScratchScope);
+
+    ~ScratchScope() {
+      __stack.rewindTo(__mark);
+    }
+
+    AllocType& get() { return __alloc; }
+    bool isValid() const { return !__alloc.isEmpty(); }
+    /// The size passed to the constructor.
+    usize requested() const { return __requested; }
+
+  private:
+    static AllocType Make(ScratchStack& S, usize n) {
+      void* P = S.push(AllocType::AllocationSize(n), alignof(T));
+      return AllocType::New(static_cast<T*>(P), P ? n : 0);
+    }
+
+  private:
+    ScratchStack& __stack;
+    usize __mark;
+    AllocType __alloc;
+    usize __requested;
+  };
+
+  /// Widens `S` into `out`, adding a null terminator.
+  inline void __widen_into(DynAllocation<wchar_t>& out, const char* S) {
+    __hc_invariant(out.size() != 0);
+    const usize len = out.size() - 1;
+    for (usize Ix = 0; Ix < len; ++Ix)
+      out[Ix] = static_cast<wchar_t>(S[Ix]);
+    out[len] = L'\0';
+  }
+} // namespace hc::common
@@ -0,0 +1,156 @@
+//===- Common/SlabAllocator.hpp -------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A size-class slab allocator. Small objects are carved from aligned
+//  slabs, tracked with a bitmap in the slab header. Larger objects get
+//  their own block. All memory comes from a `PageProvider`, so nothing
+//  here depends on the platform.
+//
+//  Threads should allocate through their own `SlabCache`, which only
+//  takes the shared locks to move objects in batches.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Sys/AtomicMutex.hpp>
+#include "Fundamental.hpp"
+#include "PageProvider.hpp"
+
+namespace hc::common {
+  /// The header at the start of every block from the `PageProvider`.
+  struct SlabHeader {
+    static constexpr u32 kMagic = 0x42414C53; // "SLAB"
+    static constexpr usize bitWords = 64;
+    enum Kind : u8 { Slab, Large };
+  public:
+    u32 magic = kMagic;
+    Kind kind = Slab;
+    u8 size_class = 0;
+    u16 hint = 0;
+    u32 object_size = 0;
+    /// Offset of the first object.
+    u32 first = 0;
+    u32 capacity = 0;
+    u32 used = 0;
+    SlabHeader* next = nullptr;
+    SlabHeader* prev = nullptr;
+    /// The size of the block from the `PageProvider`.
+    usize block_size = 0;
+    /// A bit is set when the matching object is in use.
+    u64 bits[bitWords] {};
+  };
+
+  struct SlabAllocator {
+    static constexpr usize slabShift = 16;
+    /// Blocks from the `PageProvider` must be aligned to this.
+    static constexpr usize slabSize = usize(1) << slabShift;
+    static constexpr usize minClassShift = 4;
+    static constexpr usize maxClassShift = 12;
+    static constexpr usize classCount = maxClassShift - minClassShift + 1;
+    /// The largest size served from slabs.
+    static constexpr usize maxSmallSize = usize(1) << maxClassShift;
+    /// The offset of large objects in their block.
+    static constexpr usize largeOffset = (sizeof(SlabHeader) + 63) & ~usize(63);
+    static_assert((slabSize >> minClassShift) <= SlabHeader::bitWords * 64);
+  public:
+    constexpr SlabAllocator() = default;
+    constexpr explicit SlabAllocator(PageProvider pages) : __pages(pages) {}
+    HC_MARK_DELETED(SlabAllocator);
+    /// Releases every slab. Large objects must already be freed.
+    ~SlabAllocator();
+
+    /// @return A block of at least `size` bytes, or `nullptr`.
+    [[nodiscard]] void* allocate(usize size);
+    /// Frees a block from any `SlabAllocator` with the same provider.
+    void deallocate(void* P);
+
+    /// Allocates up to `n` objects of `size_class` into `out`.
+    /// @return The number of objects allocated.
+    usize allocateBatch(usize size_class, void** out, usize n);
+    /// Frees `n` objects of `size_class`.
+    void deallocateBatch(usize size_class, void* const* in, usize n);
+
+    /// @return The size class for `size`, or `classCount` if too large.
+    static usize ClassOf(usize size) {
+      if (size <= (usize(1) << minClassShift))
+        return 0;
+      if __expect_false(size > maxSmallSize)
+        return classCount;
+      const usize shift = __bitsizeof(u64) - __builtin_clzll(u64(size - 1));
+      return shift - minClassShift;
+    }
+
+    static constexpr usize SizeOfClass(usize size_class) {
+      return usize(1) << (size_class + minClassShift);
+    }
+
+    /// @return The header of the block holding `P`.
+    static SlabHeader* HeaderOf(void* P) {
+      auto* H = reinterpret_cast<SlabHeader*>(uptr(P) & ~(slabSize - 1));
+      __hc_invariant(H->magic == SlabHeader::kMagic);
+      return H;
+    }
+
+  private:
+    struct Bin {
+      sys::AtomicMtx mtx {};
+      /// Slabs with free objects.
+      SlabHeader* partial = nullptr;
+      SlabHeader* full = nullptr;
+    };
+
+    SlabHeader* newSlab(usize size_class);
+    void* allocateLarge(usize size);
+    void releaseBlock(SlabHeader* H);
+
+  private:
+    Bin __bins[classCount] {};
+    PageProvider __pages {};
+  };
+
+  /// A per-thread front for `SlabAllocator`.
+  /// Keeps a few free objects for each size class.
+  struct SlabCache {
+    /// The number of objects moved to or from the heap at once.
+    static constexpr usize batchSize = 16;
+    static constexpr usize binSize = batchSize * 2;
+    static constexpr usize classCount = SlabAllocator::classCount;
+  public:
+    constexpr SlabCache() = default;
+    constexpr explicit SlabCache(SlabAllocator& heap) : __heap(&heap) {}
+    HC_MARK_DELETED(SlabCache);
+    ~SlabCache() { this->flush(); }
+
+    [[nodiscard]] void* allocate(usize size);
+    void deallocate(void* P);
+
+    /// Returns every cached object to the heap.
+    void flush();
+
+  private:
+    struct Bin {
+      usize count = 0;
+      void* items[binSize];
+    };
+
+  private:
+    SlabAllocator* __heap = nullptr;
+    Bin __bins[classCount] {};
+  };
+} // namespace hc::common
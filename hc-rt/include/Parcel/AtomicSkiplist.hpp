@@ -0,0 +1,161 @@
+//===- Parcel/AtomicSkiplist.hpp ------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A lock-free variant of `Skiplist`. Slots are claimed by setting
+//  their bit with a CAS, and released with an atomic `and`, so
+//  insertions and erasures can happen from multiple threads.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Limits.hpp>
+#include <Common/RawLazy.hpp>
+#include <Sys/Atomic.hpp>
+#include "Skiplist.hpp"
+
+namespace hc::parcel {
+  /// Thread-safe slot pool with the same interface as `Skiplist`.
+  /// Elements are constructed after their slot is claimed, so only
+  /// the owner of a slot may access or erase it.
+  template <typename T, usize N>
+  struct AtomicSkiplist {
+    using SelfType = AtomicSkiplist;
+    using DataType = com::RawLazy<T>;
+    using Type = T;
+    using BitType = uptr;
+    using WordType = sys::Atomic<BitType>;
+    using HandleType = SkiplistHandle<T, SelfType>;
+    static constexpr auto __bSize = __bitsizeof(BitType);
+    static constexpr auto __full  = Max<BitType>;
+    static constexpr usize __words = (N + (__bSize - 1)) / __bSize;
+    static_assert(N > 0, "AtomicSkiplist must have at least 1 slot.");
+
+  public:
+    constexpr AtomicSkiplist() = default;
+    AtomicSkiplist(const AtomicSkiplist&) = delete;
+    AtomicSkiplist& operator=(const AtomicSkiplist&) = delete;
+
+    /// Not thread-safe, every handle must be gone by now.
+    ~AtomicSkiplist() {
+      for (usize J = 0; J < __words; ++J) {
+        BitType W = __bits[J].load(sys::MemoryOrder::Acquire);
+        while (W != 0) {
+          const usize V = (J * __bSize) + __builtin_ctzll(W);
+          __data[V].dtor();
+          W &= (W - 1);
+        }
+      }
+    }
+
+    static constexpr usize FindEmptySlot(BitType S) {
+      return Skiplist<T, N>::FindEmptySlot(S);
+    }
+
+    [[nodiscard]] HandleType insert(auto&&...args) {
+      return {insertRaw(__hc_fwd(args)...), this};
+    }
+
+    [[nodiscard]] T* insertRaw(auto&&...args) {
+      const isize V = this->claimSlot();
+      if __expect_false(V < 0)
+        return nullptr;
+      __data[V].ctor(__hc_fwd(args)...);
+      return __data[V].data();
+    }
+
+    bool eraseRaw(T* P) {
+      using enum sys::MemoryOrder;
+      if __expect_false(P == nullptr)
+        return false;
+      __hc_invariant(inRange(P));
+      const usize V = P - __begin();
+      const usize J = V / __bSize;
+      const BitType mask = BitType(1) << (V % __bSize);
+      if __expect_false(!(__bits[J].load(Relaxed) & mask))
+        return false;
+      // Destroy before releasing, the slot may be reclaimed instantly.
+      __data[V].dtor();
+      __bits[J].fetchAnd(~mask, Release);
+      // Point new insertions at the now open word.
+      __hint.store(J, Relaxed);
+      return true;
+    }
+
+    bool inRange(T* P) const {
+      return P >= __begin() && P < __end();
+    }
+
+    constexpr const T* __begin() const {
+      return __data[0].data();
+    }
+
+    constexpr const T* __end() const {
+      return __data[0].data() + N;
+    }
+
+    /// Returns the amount of initialized elements. Only a snapshot.
+    usize countActive() const {
+      usize total = 0;
+      for (const WordType& W : __bits)
+        total += __builtin_popcountll(
+          const_cast<WordType&>(W).load(sys::MemoryOrder::Relaxed));
+      return total;
+    }
+
+    /// Returns the amount of uninitialized elements. Only a snapshot.
+    usize countInactive() const {
+      return N - this->countActive();
+    }
+
+  private:
+    /// Claims the lowest open bit, starting at the last hinted word.
+    /// @return The claimed index, or `-1` if the list is full.
+    isize claimSlot() {
+      using enum sys::MemoryOrder;
+      const usize start = __hint.load(Relaxed);
+      for (usize K = 0; K < __words; ++K) {
+        usize J = start + K;
+        if (J >= __words)
+          J -= __words;
+        BitType W = __bits[J].load(Relaxed);
+        while (W != __full) {
+          const usize off = FindEmptySlot(W);
+          const usize V = (J * __bSize) + off;
+          // Only the padding bits are left.
+          if __expect_false(V >= N)
+            break;
+          const BitType next = W | (BitType(1) << off);
+          // On failure `W` is reloaded, so just try again.
+          if (__bits[J].cmpxchg(W, next, Acquire, Relaxed)) {
+            if (next == __full)
+              __hint.store(J + 1 < __words ? J + 1 : 0, Relaxed);
+            return isize(V);
+          }
+        }
+      }
+      return -1;
+    }
+
+  public:
+    DataType __data[N] {};
+    WordType __bits[__words] {};
+    /// The word to start searching from. Only a heuristic.
+    sys::Atomic<usize> __hint {};
+  };
+} // namespace hc::parcel
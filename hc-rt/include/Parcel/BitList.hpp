@@ -24,6 +24,7 @@
 #pragma once
 
 #include "_BitRef.hpp"
+#include "_BitOps.hpp"
 #include <Common/Memory.hpp>
 
 namespace hc::parcel {
@@ -73,15 +74,102 @@ namespace hc::parcel {
 
     /// Returns the number of bits set to `1`.
     constexpr usize countActive() const {
-      usize total = 0;
-      for (BitListType I : __data)
-        total += com::popcnt(I);
-      return total;
+      if $is_consteval() {
+        usize total = 0;
+        for (BitListType I : __data)
+          total += com::popcnt(I);
+        return total;
+      }
+      return BitOps::Count(__data, __count);
     }
 
     /// Returns the number of bits set to `0`.
     inline constexpr usize countInactive() const {
-      return __count - this->countActive();
+      return Size() - this->countActive();
+    }
+
+    /// Returns the first set bit at or after `I`, or `-1`.
+    constexpr isize findNextSet(usize I = 0) const {
+      isize R = -1;
+      if $is_consteval() {
+        for (; I < Size(); ++I) {
+          if (this->get(I))
+            return isize(I);
+        }
+      } else {
+        R = BitOps::FindNext(__data, __count, I);
+      }
+      // Ignore the padding bits.
+      return (R < isize(Size())) ? R : -1;
+    }
+
+    /// Sets the bits in `[begin, end)` to `1`.
+    constexpr BitList& setRange(usize begin, usize end) {
+      __hc_invariant(begin <= end && end <= Size());
+      if $is_consteval() {
+        for (; begin < end; ++begin)
+          this->set(begin);
+      } else {
+        BitOps::SetRange(__data, begin, end);
+      }
+      return *this;
+    }
+
+    /// Sets the bits in `[begin, end)` to `0`.
+    constexpr BitList& clearRange(usize begin, usize end) {
+      __hc_invariant(begin <= end && end <= Size());
+      if $is_consteval() {
+        for (; begin < end; ++begin)
+          __data[Idx(begin)] &= ~BitListType(Off(begin));
+      } else {
+        BitOps::ClearRange(__data, begin, end);
+      }
+      return *this;
+    }
+
+    //==================================================================//
+    // Bulk Operations
+    //==================================================================//
+
+    constexpr BitList& operator&=(const BitList& rhs) {
+      if $is_consteval() {
+        for (usize I = 0; I < __count; ++I)
+          __data[I] &= rhs.__data[I];
+      } else {
+        BitOps::And(__data, rhs.__data, __count);
+      }
+      return *this;
+    }
+
+    constexpr BitList& operator|=(const BitList& rhs) {
+      if $is_consteval() {
+        for (usize I = 0; I < __count; ++I)
+          __data[I] |= rhs.__data[I];
+      } else {
+        BitOps::Or(__data, rhs.__data, __count);
+      }
+      return *this;
+    }
+
+    constexpr BitList& operator^=(const BitList& rhs) {
+      if $is_consteval() {
+        for (usize I = 0; I < __count; ++I)
+          __data[I] ^= rhs.__data[I];
+      } else {
+        BitOps::Xor(__data, rhs.__data, __count);
+      }
+      return *this;
+    }
+
+    /// Clears every bit which is set in `rhs`.
+    constexpr BitList& andNot(const BitList& rhs) {
+      if $is_consteval() {
+        for (usize I = 0; I < __count; ++I)
+          __data[I] &= ~rhs.__data[I];
+      } else {
+        BitOps::AndNot(__data, rhs.__data, __count);
+      }
+      return *this;
     }
 
     constexpr auto __uData()
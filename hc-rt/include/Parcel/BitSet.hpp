@@ -30,6 +30,8 @@ namespace hc::parcel {
     using BaseType::__perIx;
     using BaseType::__count;
     using BaseType::bitCount;
+    static constexpr u64 __lastMask
+      = (u64(1) << (N % __perIx)) - 1;
   private:
     // Hide irrelevant/conflicting stuff.
     using BaseType::countActive;
@@ -40,6 +42,9 @@ namespace hc::parcel {
   public:
     using BaseType::set;
     using BaseType::get;
+    using BaseType::findNextSet;
+    using BaseType::setRange;
+    using BaseType::clearRange;
 
     inline constexpr bool
      test(usize I) const {
@@ -50,6 +55,33 @@ namespace hc::parcel {
       for (usize I = 0; I < __count; ++I)
         BaseType::__data[I] 
           = ~BaseType::__data[I];
+      // Keep the padding clear, so counts stay correct.
+      BaseType::__data[__count - 1] &= __lastMask;
+    }
+
+    /// Returns the number of set bits.
+    inline constexpr usize count() const {
+      return BaseType::countActive();
+    }
+
+    inline constexpr SelfType& operator&=(const SelfType& R) {
+      (void) BaseType::operator&=(R);
+      return *this;
+    }
+
+    inline constexpr SelfType& operator|=(const SelfType& R) {
+      (void) BaseType::operator|=(R);
+      return *this;
+    }
+
+    inline constexpr SelfType& operator^=(const SelfType& R) {
+      (void) BaseType::operator^=(R);
+      return *this;
+    }
+
+    inline constexpr SelfType& andNot(const SelfType& R) {
+      (void) BaseType::andNot(R);
+      return *this;
     }
 
     inline constexpr void reset() {
@@ -0,0 +1,120 @@
+//===- Parcel/ConcurrentStringTable.hpp -----------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  An intern table which can be used from multiple threads. Strings
+//  are hashed into independently locked, hashed `StringTable` shards,
+//  so producers only contend when they land on the same shard.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Align.hpp>
+#include <Meta/Traits.hpp>
+#include <Parcel/StringTable.hpp>
+#include <Sys/AtomicMutex.hpp>
+#include <Sys/Locks.hpp>
+
+namespace hc::parcel {
+  /// Sharded intern table. Strings are never removed, and shard buffers
+  /// never move, so returned `StrRef`s are valid for the table's lifetime.
+  /// @tparam Shards The number of shards, must be a power of 2.
+  /// @tparam BufferSize The character capacity of each shard.
+  /// @tparam TableSize The string capacity of each shard.
+  template <usize Shards, usize BufferSize, usize TableSize,
+    typename MtxType = sys::AtomicMtx>
+  struct [[gsl::Owner]] ConcurrentStringTable {
+    static_assert(Shards != 0 && (Shards & (Shards - 1)) == 0,
+      "Shards must be a power of 2.");
+    using IntType = meta::__conditional_t<
+      (BufferSize <= usize(Max<u16>)), u16, u32>;
+    using SelfType  = ConcurrentStringTable;
+    using TableType = BasicStringTable<IntType, BufferSize, TableSize,
+      com::Align::Up(TableSize * 2 - 1)>;
+    using Status = typename TableType::BaseType::Status;
+    static constexpr usize shardShift
+      = 64 - __builtin_ctzll(u64(Shards));
+
+    /// Keeps each lock on its own cache line.
+    struct alignas(64) Shard : TableType {
+      using TableType::locateString;
+      mutable MtxType mtx {};
+    };
+
+  public:
+    constexpr ConcurrentStringTable() = default;
+    HC_MARK_DELETED(ConcurrentStringTable);
+
+    /// Interns `S`, returning the existing string if already present.
+    com::Pair<com::StrRef, Status> insert(com::StrRef S) {
+      S.dropNullMut();
+      Shard& shard = this->shardFor(S);
+      sys::ScopedLock L(shard.mtx);
+      return shard->insert(S);
+    }
+
+    /// @return The interned string, or `invalidString` if not found.
+    com::StrRef locate(com::StrRef S) const {
+      S.dropNullMut();
+      const Shard& shard = this->shardFor(S);
+      sys::ScopedLock L(shard.mtx);
+      return shard.locateString(S);
+    }
+
+    /// @return The total number of strings. Only a snapshot.
+    usize size() const {
+      usize total = 0;
+      for (const Shard& shard : __shards) {
+        sys::ScopedLock L(shard.mtx);
+        total += shard->size();
+      }
+      return total;
+    }
+
+    static constexpr usize shardCount() { return Shards; }
+
+    /// @brief The case for invalid lookups.
+    static constexpr auto invalidString
+      = com::StrRef::New(nullptr, usize(0));
+
+  private:
+    /// FNV-1a, using the high bits so shards don't correlate
+    /// with the slots used by each shard's hash index.
+    static usize ShardIndex(com::StrRef S) {
+      if constexpr (Shards == 1) {
+        return 0;
+      } else {
+        u64 H = 0xCBF29CE484222325ULL;
+        for (const char C : S)
+          H = (H ^ u8(C)) * 0x100000001B3ULL;
+        return usize(H >> shardShift);
+      }
+    }
+
+    Shard& shardFor(com::StrRef S) {
+      return __shards[SelfType::ShardIndex(S)];
+    }
+
+    const Shard& shardFor(com::StrRef S) const {
+      return __shards[SelfType::ShardIndex(S)];
+    }
+
+  private:
+    Shard __shards[Shards] {};
+  };
+} // namespace hc::parcel
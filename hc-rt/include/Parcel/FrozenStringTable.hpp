@@ -0,0 +1,115 @@
+//===- Parcel/FrozenStringTable.hpp ---------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A read-only view over an image created with `IStringTable::freeze`.
+//  Strings are stored in shortlex order, split into buckets. The first
+//  string of each bucket is stored in full, and the rest only store
+//  the suffix that differs from the previous string (front-coding).
+//
+//  Image layout (all offsets are relative to the image start):
+//    FrozenStrTblHeader
+//    u32[bucket_count]  - Bucket offsets, relative to `data_offset`.
+//    u8[data_size]      - Bucket data.
+//
+//  Bucket heads are `[len:uleb][bytes]`, and every other entry
+//  is `[shared:uleb][suffix_len:uleb][suffix bytes]`.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Fundamental.hpp>
+#include <Common/PtrRange.hpp>
+#include <Common/StrRef.hpp>
+
+namespace hc::parcel {
+  struct FrozenStrTblHeader {
+    static constexpr u32 kMagic   = 0x46535448; // 'HTSF'
+    static constexpr u16 kVersion = 1;
+    enum : u8 {
+      has_empty = 0b01, // The table "contains" the empty string.
+    };
+  public:
+    u32 magic         = kMagic;
+    u16 version       = kVersion;
+    u8  bucket_shift  = 0; // log2 of the strings per bucket.
+    u8  flags         = 0;
+    u32 count         = 0; // Does not include the implicit empty string.
+    u32 bucket_count  = 0;
+    u32 index_offset  = 0;
+    u32 data_offset   = 0;
+    u32 data_size     = 0;
+    u32 max_length    = 0; // The length of the longest string.
+  };
+
+  static_assert(sizeof(FrozenStrTblHeader) == 32);
+
+  /// Binary searches a frozen table directly from its image, so it can
+  /// be used from a mapped file or embedded data without copying.
+  /// Since strings are front-coded, they must be decoded to be read.
+  struct [[gsl::Pointer]] FrozenStringTable {
+    using HeaderType = FrozenStrTblHeader;
+    /// The number of strings per bucket when freezing.
+    static constexpr u8 bucketShift = 4;
+  public:
+    /// Validates the image header and bounds.
+    /// @return An empty table if the image is invalid.
+    static FrozenStringTable New(com::ImmAddrRange image);
+
+    /// @return The position of `S` in shortlex order, or `-1`.
+    /// If the table has the empty string, it is always at `0`.
+    isize indexOf(com::StrRef S) const;
+
+    bool contains(com::StrRef S) const {
+      return this->indexOf(S) >= 0;
+    }
+
+    /// Decodes the string at `Ix` into `out`. Null-terminates if
+    /// `out` has space. `out` should have at least `maxLength()` bytes.
+    /// @return The decoded string, or `invalidString` on failure.
+    com::StrRef resolveAt(usize Ix, com::PtrRange<char> out) const;
+
+    bool isValid() const { return this->image != nullptr; }
+    bool hasEmpty() const {
+      return this->header.flags & HeaderType::has_empty;
+    }
+
+    /// @return The number of strings, including the implicit empty string.
+    usize size() const { return header.count + this->hasEmpty(); }
+    usize maxLength() const { return header.max_length; }
+    usize sizeInBytes() const { return header.data_size; }
+
+    /// @brief The case for invalid lookups.
+    static constexpr auto invalidString
+      = com::StrRef::New(nullptr, usize(0));
+
+  private:
+    const u8* bucketAt(usize Ix) const;
+    const u8* bucketEnd(usize Ix) const;
+    /// Returns the first string in a bucket, which is stored in full.
+    com::StrRef headAt(usize Ix) const;
+    /// Finds the last bucket with a head `<=` `S`, or `-1`.
+    isize findBucket(com::StrRef S) const;
+
+  public:
+    const u8* image = nullptr;
+    const u8* index = nullptr;
+    const u8* data  = nullptr;
+    HeaderType header {};
+  };
+} // namespace hc::parcel
@@ -0,0 +1,258 @@
+//===- Parcel/GrowableVec.hpp ---------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A `StaticVec` which starts with inline storage, and spills into
+//  memory from a chunked arena when full. Since it is still an
+//  `IStaticVec`, it can be passed to existing code unchanged, though
+//  only its own mutators grow. `StaticVec` itself has no growth hook.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Align.hpp>
+#include <Common/Lifetime.hpp>
+#include <Common/Memory.hpp>
+#include "StaticVec.hpp"
+
+namespace hc::parcel {
+  /// A bump allocator over caller-provided chunks of memory.
+  /// Allocations are never freed individually, only on `reset`.
+  template <usize MaxChunks = 16>
+  struct [[gsl::Pointer]] VecArena {
+    using ChunkType = com::PtrRange<u8>;
+  public:
+    constexpr VecArena() = default;
+    HC_MARK_DELETED(VecArena);
+
+    /// Adds a new chunk to carve allocations from.
+    /// @return `false` if there are no chunk slots left.
+    bool addChunk(com::AddrRange chunk) {
+      auto* const P = static_cast<u8*>(chunk.data());
+      if __expect_false(!P || chunk.isEmpty())
+        return false;
+      return __chunks.pushBack(
+        ChunkType::New(P, chunk.size())).isSome();
+    }
+
+    /// @return An aligned block of `size` bytes, or `nullptr`.
+    void* allocate(usize size, usize align) {
+      while (__curr < __chunks.size()) {
+        const ChunkType C = __chunks[__curr];
+        const uptr base = uptr(C.data()) + __offset;
+        const uptr aligned = (base + (align - 1)) & ~uptr(align - 1);
+        const usize used = (aligned - uptr(C.data())) + size;
+        if (used <= C.size()) {
+          this->__offset = used;
+          return reinterpret_cast<void*>(aligned);
+        }
+        // Move to the next chunk, this one can't hold the block.
+        ++this->__curr;
+        this->__offset = 0;
+      }
+      return nullptr;
+    }
+
+    /// Arena blocks are only freed on `reset`.
+    void deallocate(void*, usize, usize) {}
+
+    /// Releases every allocation, keeping the chunks.
+    void reset() {
+      this->__curr = 0;
+      this->__offset = 0;
+    }
+
+  private:
+    StaticVec<ChunkType, MaxChunks> __chunks;
+    usize __curr = 0;
+    usize __offset = 0;
+  };
+
+  /// The interface used by growable vectors to get memory.
+  template <typename A>
+  concept __is_vec_allocator = requires(A& a, void* P, usize n) {
+    { a.allocate(n, n) } -> meta::is_same<void*>;
+    a.deallocate(P, n, n);
+  };
+
+  /// @brief `StaticVec` whose mutators grow past its capacity, by
+  /// moving into blocks from `Alloc`. Plain `StaticVec`s are unchanged,
+  /// and code using `IStaticVec<T>` only sees the current capacity.
+  /// @tparam T The array element type.
+  /// @tparam InlineSize The amount of elements stored inline.
+  /// @tparam Alloc The allocator to spill into.
+  template <typename T, usize InlineSize, typename Alloc>
+  requires __is_vec_allocator<Alloc>
+  struct GrowableVecBase : public StaticVec<T, InlineSize> {
+    using BaseType  = StaticVec<T, InlineSize>;
+    using AllocType = Alloc;
+  public:
+    constexpr GrowableVecBase() : BaseType() {}
+    constexpr GrowableVecBase(Alloc* A) : BaseType(), __alloc(A) {}
+
+    /// Checks if `N` more elements can be added, growing if there
+    /// isn't space. May relocate the elements.
+    /// @return `true` if there is space for `N` more elements.
+    bool canGrowBy(usize N) {
+      if __expect_true(N <= usize(this->__remainingCapacity()))
+        return true;
+      return this->grow(usize(this->size()) + N);
+    }
+
+    /// Makes space for at least `n` elements.
+    /// @return `true` if the capacity is large enough.
+    bool reserve(usize n) {
+      if (n <= this->capacity())
+        return true;
+      return this->canGrowBy(n - this->size());
+    }
+
+    /// @return The old end, or `nullptr` if growing failed.
+    T* growUninit(usize N = 1) {
+      __hc_invariant(N != 0);
+      // May relocate, so get the end afterwards.
+      if __expect_false(!this->canGrowBy(N))
+        return nullptr;
+      return BaseType::growUninit(N);
+    }
+
+    bool resizeUninit(usize n) {
+      if __expect_false(!this->reserve(n))
+        return false;
+      return BaseType::resizeUninit(n);
+    }
+
+    void push(const T& V) {
+      if __expect_true(this->canGrowBy(1))
+        BaseType::push(V);
+    }
+
+    void push(T&& V) {
+      if __expect_true(this->canGrowBy(1))
+        BaseType::push(__hc_move(V));
+    }
+
+    com::Option<T&> pushBack(const T& V) {
+      if __expect_false(!this->canGrowBy(1))
+        return $None();
+      return BaseType::pushBack(V);
+    }
+
+    com::Option<T&> pushBack(T&& V) {
+      if __expect_false(!this->canGrowBy(1))
+        return $None();
+      return BaseType::pushBack(__hc_move(V));
+    }
+
+    void emplace(auto&&...args) {
+      if __expect_true(this->canGrowBy(1))
+        BaseType::emplace(__hc_fwd(args)...);
+    }
+
+    com::Option<T&> emplaceBack(auto&&...args) {
+      if __expect_false(!this->canGrowBy(1))
+        return $None();
+      return BaseType::emplaceBack(__hc_fwd(args)...);
+    }
+
+    /// @return `true` if the elements are no longer stored inline.
+    bool isSpilled() const {
+      return this->data() != BaseType::StorageType::__data();
+    }
+
+  protected:
+    bool grow(usize min_cap) {
+      if __expect_false(!this->__alloc)
+        return false;
+      // Grow geometrically, but fall back to the exact size.
+      usize new_cap = this->capacity() * 2;
+      if (new_cap < min_cap)
+        new_cap = min_cap;
+      if __expect_false(new_cap > BaseType::MaxSize())
+        return false;
+      void* P = __alloc->allocate(new_cap * sizeof(T), alignof(T));
+      if (!P && new_cap != min_cap) {
+        new_cap = min_cap;
+        P = __alloc->allocate(new_cap * sizeof(T), alignof(T));
+      }
+      if __expect_false(!P)
+        return false;
+      this->relocateTo(static_cast<T*>(P), new_cap);
+      return true;
+    }
+
+    /// Moves the elements to `P`, returning the old block if spilled.
+    void relocateTo(T* P, usize new_cap) {
+      T* const old = this->data();
+      const usize old_cap = this->capacity();
+      const bool was_spilled = this->isSpilled();
+      const usize len = this->size();
+      if constexpr (meta::is_trivially_relocatable<T>) {
+        if (len != 0)
+          com::Mem::VCopy(P, old, len * sizeof(T));
+      } else {
+        for (usize Ix = 0; Ix < len; ++Ix) {
+          com::construct_at(P + Ix, __hc_move(old[Ix]));
+          old[Ix].~T();
+        }
+      }
+      this->__setPtr(P);
+      this->__setCap(new_cap);
+      if (was_spilled)
+        __alloc->deallocate(old, old_cap * sizeof(T), alignof(T));
+    }
+
+    /// Returns the spilled block, and goes back to inline storage.
+    void release() {
+      if (!this->isSpilled())
+        return;
+      __alloc->deallocate(this->data(),
+        this->capacity() * sizeof(T), alignof(T));
+      this->__setPtr(BaseType::StorageType::__data());
+      this->__setCap(InlineSize);
+    }
+
+  protected:
+    Alloc* __alloc = nullptr;
+  };
+
+  /// @brief `StaticVec` which spills into an arena when full.
+  /// Spilling relocates the elements, so pointers into the vector
+  /// are invalidated. Indices and offsets stay valid. Old blocks are
+  /// abandoned, they are freed when the arena is `reset`.
+  /// @tparam T The array element type.
+  /// @tparam InlineSize The amount of elements stored inline.
+  /// @tparam ArenaType The arena to allocate from.
+  template <typename T, usize InlineSize,
+    typename ArenaType = VecArena<>>
+  struct [[gsl::Owner]] GrowableVec
+   : public GrowableVecBase<T, InlineSize, ArenaType> {
+    using BaseType = GrowableVecBase<T, InlineSize, ArenaType>;
+    using SelfType = GrowableVec;
+  public:
+    constexpr GrowableVec() : BaseType() {}
+    constexpr GrowableVec(ArenaType& arena) : BaseType(&arena) {}
+
+    HC_MARK_DELETED(GrowableVec);
+
+    /// Sets the arena to spill into. Only affects future growth.
+    void setArena(ArenaType* arena) {
+      this->__alloc = arena;
+    }
+  };
+} // namespace hc::parcel
@@ -0,0 +1,197 @@
+//===- Parcel/Ring.hpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Bounded lock-free queues with a statically sized array backing.
+//  `SpscRing` is for a single producer and consumer, `MpmcRing` is
+//  Dmitry Vyukov's bounded queue, using a sequence number per slot.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Option.hpp>
+#include <Common/RawLazy.hpp>
+#include <Sys/Atomic.hpp>
+#include "Common.hpp"
+
+namespace hc::parcel {
+  /// Single producer, single consumer queue.
+  /// Each side caches the other's index, so the shared
+  /// lines are only touched when the cache runs out.
+  /// @tparam N The amount of slots, must be a power of 2.
+  template <typename T, usize N>
+  struct [[gsl::Owner]] SpscRing {
+    static_assert(N != 0 && (N & (N - 1)) == 0,
+      "N must be a power of 2.");
+    using SelfType = SpscRing;
+    using DataType = com::RawLazy<T>;
+    using Type = T;
+    static constexpr usize __mask = N - 1;
+  public:
+    constexpr SpscRing() = default;
+    HC_MARK_DELETED(SpscRing);
+
+    /// Not thread-safe, both sides must be done.
+    ~SpscRing() {
+      while (this->pop().isSome());
+    }
+
+    /// Only call from the producer.
+    /// @return `false` if the queue is full.
+    bool push(auto&&...args) {
+      using enum sys::MemoryOrder;
+      const usize tail = __tail.load(Relaxed);
+      if (tail - __headCache == N) {
+        this->__headCache = __head.load(Acquire);
+        if (tail - __headCache == N)
+          return false;
+      }
+      __data[tail & __mask].ctor(__hc_fwd(args)...);
+      __tail.store(tail + 1, Release);
+      return true;
+    }
+
+    /// Only call from the consumer.
+    com::Option<T> pop() {
+      using enum sys::MemoryOrder;
+      const usize head = __head.load(Relaxed);
+      if (head == __tailCache) {
+        this->__tailCache = __tail.load(Acquire);
+        if (head == __tailCache)
+          return $None();
+      }
+      T out = __data[head & __mask].take();
+      __head.store(head + 1, Release);
+      return $Some(__hc_move(out));
+    }
+
+    /// Only a snapshot.
+    usize size() const {
+      using enum sys::MemoryOrder;
+      auto& self = const_cast<SelfType&>(*this);
+      return self.__tail.load(Acquire) - self.__head.load(Acquire);
+    }
+
+    static constexpr usize Capacity() { return N; }
+
+  public:
+    /// Consumer line.
+    alignas(64) sys::Atomic<usize> __head {};
+    usize __tailCache = 0;
+    /// Producer line.
+    alignas(64) sys::Atomic<usize> __tail {};
+    usize __headCache = 0;
+    alignas(64) DataType __data[N] {};
+  };
+
+  /// Multi producer, multi consumer queue.
+  /// A slot's sequence is its position when it's free to write,
+  /// and its position + 1 when it's ready to read.
+  /// @tparam N The amount of slots, must be a power of 2.
+  template <typename T, usize N>
+  struct [[gsl::Owner]] MpmcRing {
+    static_assert(N > 1 && (N & (N - 1)) == 0,
+      "N must be a power of 2 larger than 1.");
+    using SelfType = MpmcRing;
+    using DataType = com::RawLazy<T>;
+    using Type = T;
+    static constexpr usize __mask = N - 1;
+
+    struct Cell {
+      sys::Atomic<usize> seq {};
+      DataType data {};
+    };
+
+  public:
+    constexpr MpmcRing() {
+      for (usize Ix = 0; Ix < N; ++Ix)
+        __cells[Ix].seq.set(Ix);
+    }
+    HC_MARK_DELETED(MpmcRing);
+
+    /// Not thread-safe, every thread must be done.
+    ~MpmcRing() {
+      while (this->pop().isSome());
+    }
+
+    /// @return `false` if the queue is full.
+    bool push(auto&&...args) {
+      using enum sys::MemoryOrder;
+      usize pos = __tail.load(Relaxed);
+      Cell* cell;
+      while (true) {
+        cell = &__cells[pos & __mask];
+        const usize seq = cell->seq.load(Acquire);
+        const isize diff = isize(seq) - isize(pos);
+        if (diff == 0) {
+          // On failure `pos` is reloaded.
+          if (__tail.cmpxchg(pos, pos + 1, Relaxed))
+            break;
+        } else if (diff < 0) {
+          // The consumers haven't caught up.
+          return false;
+        } else {
+          pos = __tail.load(Relaxed);
+        }
+      }
+      cell->data.ctor(__hc_fwd(args)...);
+      cell->seq.store(pos + 1, Release);
+      return true;
+    }
+
+    com::Option<T> pop() {
+      using enum sys::MemoryOrder;
+      usize pos = __head.load(Relaxed);
+      Cell* cell;
+      while (true) {
+        cell = &__cells[pos & __mask];
+        const usize seq = cell->seq.load(Acquire);
+        const isize diff = isize(seq) - isize(pos + 1);
+        if (diff == 0) {
+          if (__head.cmpxchg(pos, pos + 1, Relaxed))
+            break;
+        } else if (diff < 0) {
+          // Nothing has been written here yet.
+          return $None();
+        } else {
+          pos = __head.load(Relaxed);
+        }
+      }
+      T out = cell->data.take();
+      // Free the slot for the next lap.
+      cell->seq.store(pos + N, Release);
+      return $Some(__hc_move(out));
+    }
+
+    /// Only a snapshot.
+    usize size() const {
+      using enum sys::MemoryOrder;
+      auto& self = const_cast<SelfType&>(*this);
+      const usize tail = self.__tail.load(Relaxed);
+      const usize head = self.__head.load(Relaxed);
+      return (tail > head) ? (tail - head) : 0;
+    }
+
+    static constexpr usize Capacity() { return N; }
+
+  public:
+    alignas(64) sys::Atomic<usize> __head {};
+    alignas(64) sys::Atomic<usize> __tail {};
+    alignas(64) Cell __cells[N] {};
+  };
+} // namespace hc::parcel
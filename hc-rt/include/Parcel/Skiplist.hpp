@@ -28,6 +28,7 @@
 #include "BitList.hpp"
 
 HC_HAS_BUILTIN(ffsll);
+HC_HAS_BUILTIN(ctzll);
 
 namespace hc::parcel {
   template <typename T, usize N>
@@ -59,7 +60,8 @@ namespace hc::parcel {
   };
 
   /// Uses a `BitList` to manage `RawLazy<T>` instances.
-  /// Probably not the best choice for massive blocks.
+  /// A second `BitList` tracks which words are full, so finding a
+  /// free slot only needs `ffs` on each level.
   template <typename T, usize N>
   struct Skiplist {
     using SelfType = Skiplist;
@@ -69,12 +71,56 @@ namespace hc::parcel {
     using HandleType = SkiplistHandle<T, SelfType>;
     static constexpr auto __bSize = __bitsizeof(BitType);
     static constexpr auto __full  = Max<BitType>;
+    static constexpr usize __words = BitList<N, BitType>::__USize();
+
+    /// Walks the initialized elements using the set bits.
+    struct ActiveIterator {
+      constexpr T& operator*() const {
+        return *__list->__data[this->index()].data();
+      }
+      constexpr T* operator->() const {
+        return __list->__data[this->index()].data();
+      }
+
+      constexpr ActiveIterator& operator++() {
+        // Clear the lowest bit, then find the next non-empty word.
+        this->__rem &= (__rem - 1);
+        this->skipEmpty();
+        return *this;
+      }
+
+      constexpr bool operator==(const ActiveIterator& rhs) const {
+        return __word == rhs.__word && __rem == rhs.__rem;
+      }
+
+      /// The index of the current element.
+      constexpr usize index() const {
+        __hc_invariant(__rem != 0);
+        return (__word * __bSize) + __builtin_ctzll(__rem);
+      }
+
+      constexpr void skipEmpty() {
+        while (__rem == 0 && ++__word < __words)
+          this->__rem = __list->__bits.__data[__word];
+      }
+
+    public:
+      SelfType* __list;
+      usize __word;
+      BitType __rem;
+    };
+
+    struct ActiveRange {
+      constexpr ActiveIterator begin() const { return __begin; }
+      constexpr ActiveIterator end() const { return __end; }
+    public:
+      ActiveIterator __begin, __end;
+    };
+
   public:
     constexpr ~Skiplist() {
-      for (BitType I = 0; I < N; ++I) {
-        if (__bits.get(I))
-          __data[I].dtor();
-      }
+      for (auto I = activeBegin(), E = activeEnd(); I != E; ++I)
+        __data[I.index()].dtor();
     }
 
     static constexpr usize FindEmptySlot(usize S) {
@@ -87,12 +133,22 @@ namespace hc::parcel {
 
     [[nodiscard]] constexpr T* insertRaw(auto&&...args) {
       auto& B = __bits.__uData();
-      for (usize I = 0; I < __bits.__USize(); ++I) {
-        if (B[I] == Max<BitType>)
+      auto& F = __fullWords.__uData();
+      for (usize J = 0; J < __fullWords.__USize(); ++J) {
+        if (F[J] == __full)
           continue;
+        const usize I = (J * __bSize) + FindEmptySlot(F[J]);
+        // Only the padding words are left.
+        if __expect_false(I >= __words)
+          return nullptr;
         const usize V = (I * __bSize) + FindEmptySlot(B[I]);
+        // Only the padding bits are left.
+        if __expect_false(V >= N)
+          return nullptr;
         __data[V].ctor(__hc_fwd(args)...);
         __bits[V] = true;
+        if (B[I] == __full)
+          __fullWords.set(I);
         return __data[V].data();
       }
       return nullptr;
@@ -106,10 +162,26 @@ namespace hc::parcel {
       if __expect_false(!__bits.get(V))
         return false;
       __bits[V] = false;
+      __fullWords[V / __bSize] = false;
       __data[V].dtor();
       return true;
     }
 
+    constexpr ActiveIterator activeBegin() {
+      ActiveIterator I {this, 0, __bits.__data[0]};
+      I.skipEmpty();
+      return I;
+    }
+
+    constexpr ActiveIterator activeEnd() {
+      return {this, __words, 0};
+    }
+
+    /// Allows for iterating over the initialized elements.
+    constexpr ActiveRange active() {
+      return {activeBegin(), activeEnd()};
+    }
+
     constexpr bool inRange(T* P) const {
       return P >= __begin() && P < __end();
     }
@@ -135,6 +207,8 @@ namespace hc::parcel {
   public:
     DataType __data[N] {};
     BitList<N, BitType> __bits;
+    /// A bit is set when the matching word of `__bits` is full.
+    BitList<__words, BitType> __fullWords;
   };
 
   template <typename T, usize N>
@@ -0,0 +1,62 @@
+//===- Parcel/SmallVec.hpp ------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A `StaticVec` which keeps a few elements inline, and moves to a
+//  pluggable allocator when full. Unlike `GrowableVec`, the spilled
+//  block is returned on destruction, so it also works with real heaps
+//  like xcrt's `BoxAllocator`.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Lifetime.hpp>
+#include <Common/Memory.hpp>
+#include "GrowableVec.hpp"
+#include "StaticVec.hpp"
+
+namespace hc::parcel {
+  /// @brief `StaticVec` which spills into an allocator when full.
+  /// Spilling relocates the elements, so pointers into the vector
+  /// are invalidated. Can be read through `IStaticVec<T>`.
+  /// @tparam T The array element type.
+  /// @tparam N The amount of elements stored inline.
+  /// @tparam Alloc The allocator to spill into.
+  template <typename T, usize N, typename Alloc = VecArena<>>
+  requires __is_vec_allocator<Alloc>
+  struct [[gsl::Owner]] SmallVec : public GrowableVecBase<T, N, Alloc> {
+    using BaseType  = GrowableVecBase<T, N, Alloc>;
+    using SelfType  = SmallVec;
+    using AllocType = Alloc;
+  public:
+    constexpr SmallVec() : BaseType() {}
+    constexpr SmallVec(Alloc& A) : BaseType(&A) {}
+
+    HC_MARK_DELETED(SmallVec);
+
+    ~SmallVec() {
+      // Destroy here, the base can't see the spilled block.
+      this->clear();
+      this->release();
+    }
+
+    Alloc* getAllocator() const {
+      return this->__alloc;
+    }
+  };
+} // namespace hc::parcel
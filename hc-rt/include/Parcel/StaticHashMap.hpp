@@ -0,0 +1,284 @@
+//===- Parcel/StaticHashMap.hpp -------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  An open-addressing hash map with a statically sized array backing.
+//  Slots are tagged with SwissTable-style control bytes, which are
+//  matched 16 at a time. Probing is linear, so erasing can shift
+//  the following entries back instead of leaving tombstones.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Fundamental.hpp>
+#include <Common/Memory.hpp>
+#include <Common/Pair.hpp>
+#include <Common/RawLazy.hpp>
+#include <Common/StrRef.hpp>
+#include <Meta/Traits.hpp>
+#include "Common.hpp"
+
+HC_HAS_BUILTIN(ctz);
+
+namespace hc::parcel {
+  /// The default hasher for `StaticHashMap`.
+  struct StaticHash {
+    static constexpr u64 __mul = 0x9E3779B97F4A7C15ULL;
+  public:
+    /// Finalizer from MurmurHash3, spreads the entropy to the tag bits.
+    static constexpr u64 Mix(u64 H) {
+      H ^= (H >> 33);
+      H *= 0xFF51AFD7ED558CCDULL;
+      H ^= (H >> 33);
+      H *= 0xC4CEB93FE1A85EC9ULL;
+      return H ^ (H >> 33);
+    }
+
+    template <typename T>
+    requires(meta::is_integral<T> || __is_enum(T))
+    constexpr u64 operator()(T V) const {
+      return Mix(u64(V));
+    }
+
+    template <typename T>
+    u64 operator()(T* P) const {
+      return Mix(u64(uptr(P)));
+    }
+
+    u64 operator()(com::StrRef S) const {
+      auto* P = reinterpret_cast<const u8*>(S.data());
+      usize len = S.size();
+      u64 H = u64(len) * __mul;
+      for (; len >= 8; len -= 8, P += 8) {
+        u64 W = 0;
+        com::__vmemcpy<sizeof(u64)>(&W, P);
+        H = (H ^ W) * __mul;
+        H ^= (H >> 29);
+      }
+      if (len != 0) {
+        u64 W = 0;
+        for (usize Ix = 0; Ix < len; ++Ix)
+          W |= u64(P[Ix]) << (Ix * 8);
+        H = (H ^ W) * __mul;
+      }
+      return Mix(H);
+    }
+  };
+
+  /// A window of control bytes.
+  /// Empty slots are `0`, full slots are `0x80 | tag`.
+  struct _HashGroup {
+    static constexpr usize Width = 16;
+    static constexpr u8 Empty = 0x00;
+#ifdef __SSE2__
+    // Matches `Gv128` from `SSEVec`, which is private to the runtime.
+    using VecType  = u8 __attribute__((__vector_size__(16)));
+    using MaskType = i8 __attribute__((__vector_size__(16)));
+#endif
+  public:
+    /// @return A mask of the bytes equal to `ctrl`.
+    __always_inline static u32 Match(const u8* P, u8 ctrl) {
+#ifdef __SSE2__
+      VecType V;
+      com::__vmemcpy<Width>(&V, P);
+      return u32(__builtin_ia32_pmovmskb128(MaskType(V == ctrl)));
+#else
+      u32 mask = 0;
+      for (usize Ix = 0; Ix < Width; ++Ix)
+        mask |= u32(P[Ix] == ctrl) << Ix;
+      return mask;
+#endif
+    }
+
+    /// @return A mask of the empty slots.
+    __always_inline static u32 MatchEmpty(const u8* P) {
+      return Match(P, Empty);
+    }
+  };
+
+  /// @brief Hash map with a statically sized array backing.
+  /// Entries move when others are erased, so pointers to values are
+  /// only valid until the next erasure.
+  /// @tparam N The amount of slots, must be a power of 2.
+  template <typename K, typename V, usize N,
+    typename HashFn = StaticHash>
+  struct [[gsl::Owner]] StaticHashMap {
+    static_assert(N >= _HashGroup::Width && (N & (N - 1)) == 0,
+      "N must be a power of 2, and at least the group width.");
+    using SelfType  = StaticHashMap;
+    using KeyType   = K;
+    using ValueType = V;
+    using EntryType = com::Pair<K, V>;
+    using DataType  = com::RawLazy<EntryType>;
+    using GroupType = _HashGroup;
+    static constexpr usize __mask  = N - 1;
+    static constexpr usize __width = GroupType::Width;
+    /// Keep the load factor at 7/8 so probe runs stay short.
+    static constexpr usize __maxLoad = N - (N / 8);
+  public:
+    constexpr StaticHashMap() = default;
+    HC_MARK_DELETED(StaticHashMap);
+
+    ~StaticHashMap() {
+      this->clear();
+    }
+
+    /// Inserts a value constructed from `args` if `key` is not present.
+    /// @return The value, and `true` if it was inserted. The value is
+    /// `nullptr` if the map is full.
+    com::Pair<V*, bool> insert(const K& key, auto&&...args) {
+      const u64 H = this->hash(key);
+      if (const isize slot = this->findSlot(key, H); slot >= 0)
+        return {&__slots[slot]->u, false};
+      if __expect_false(__size >= __maxLoad)
+        return {nullptr, false};
+
+      usize Ix = SelfType::Home(H);
+      while (true) {
+        const u32 empty = GroupType::MatchEmpty(__ctrl + Ix);
+        if (empty != 0) {
+          Ix = (Ix + __builtin_ctz(empty)) & __mask;
+          break;
+        }
+        Ix = (Ix + __width) & __mask;
+      }
+
+      EntryType& E = __slots[Ix].ctor(
+        key, V(__hc_fwd(args)...));
+      this->setCtrl(Ix, SelfType::Tag(H));
+      ++this->__size;
+      return {&E.u, true};
+    }
+
+    /// @return The value for `key`, or `nullptr` if not present.
+    V* find(const K& key) {
+      const isize slot = this->findSlot(key, this->hash(key));
+      return (slot >= 0) ? &__slots[slot]->u : nullptr;
+    }
+
+    /// @return The value for `key`, or `nullptr` if not present.
+    const V* find(const K& key) const {
+      const isize slot = this->findSlot(key, this->hash(key));
+      return (slot >= 0) ? &__slots[slot]->u : nullptr;
+    }
+
+    bool contains(const K& key) const {
+      return this->find(key) != nullptr;
+    }
+
+    /// Removes `key`, shifting back any entries which probed past it.
+    /// @return `true` if `key` was present.
+    bool erase(const K& key) {
+      const isize slot = this->findSlot(key, this->hash(key));
+      if (slot < 0)
+        return false;
+      usize hole = usize(slot);
+      __slots[hole].dtor();
+
+      // Move back entries whose home is at or before the hole.
+      usize Ix = (hole + 1) & __mask;
+      while (__ctrl[Ix] != GroupType::Empty) {
+        const usize home = SelfType::Home(
+          this->hash(__slots[Ix]->t));
+        if (((Ix - home) & __mask) >= ((Ix - hole) & __mask)) {
+          __slots[hole].ctor(__hc_move(__slots[Ix].unwrap()));
+          __slots[Ix].dtor();
+          this->setCtrl(hole, __ctrl[Ix]);
+          hole = Ix;
+        }
+        Ix = (Ix + 1) & __mask;
+      }
+
+      this->setCtrl(hole, GroupType::Empty);
+      --this->__size;
+      return true;
+    }
+
+    /// Destroys every entry.
+    void clear() {
+      if (__size == 0)
+        return;
+      for (usize Ix = 0; Ix < N; ++Ix) {
+        if (__ctrl[Ix] != GroupType::Empty)
+          __slots[Ix].dtor();
+      }
+      com::__array_memset(__ctrl, 0);
+      this->__size = 0;
+    }
+
+    /// Calls `F(key, value)` for each entry, in slot order.
+    void forEach(auto&& F) {
+      for (usize Ix = 0; Ix < N; ++Ix) {
+        if (__ctrl[Ix] != GroupType::Empty)
+          F(__slots[Ix]->t, __slots[Ix]->u);
+      }
+    }
+
+    constexpr usize size() const { return __size; }
+    constexpr bool isEmpty() const { return __size == 0; }
+    constexpr bool isFull() const { return __size >= __maxLoad; }
+    /// The maximum amount of entries.
+    static constexpr usize Capacity() { return __maxLoad; }
+
+  private:
+    __always_inline u64 hash(const K& key) const {
+      return HashFn{}(key);
+    }
+
+    __always_inline static usize Home(u64 H) {
+      return usize(H >> 7) & __mask;
+    }
+
+    __always_inline static u8 Tag(u64 H) {
+      return u8(0x80 | (H & 0x7F));
+    }
+
+    /// @return The slot holding `key`, or `-1`.
+    isize findSlot(const K& key, u64 H) const {
+      const u8 tag = SelfType::Tag(H);
+      usize Ix = SelfType::Home(H);
+      for (usize probed = 0; probed < N; probed += __width) {
+        const u8* const P = __ctrl + Ix;
+        u32 match = GroupType::Match(P, tag);
+        for (; match != 0; match &= (match - 1)) {
+          const usize slot = (Ix + __builtin_ctz(match)) & __mask;
+          if __expect_true(__slots[slot]->t == key)
+            return isize(slot);
+        }
+        // Probe runs are contiguous, so an empty slot ends the search.
+        if (GroupType::MatchEmpty(P) != 0)
+          return -1;
+        Ix = (Ix + __width) & __mask;
+      }
+      return -1;
+    }
+
+    /// Sets the control byte, and its mirror past the end.
+    __always_inline void setCtrl(usize Ix, u8 ctrl) {
+      this->__ctrl[Ix] = ctrl;
+      if (Ix < __width)
+        this->__ctrl[N + Ix] = ctrl;
+    }
+
+  public:
+    DataType __slots[N] {};
+    /// The first group is mirrored at the end, so windows never wrap.
+    u8 __ctrl[N + __width] {};
+    usize __size = 0;
+  };
+} // namespace hc::parcel
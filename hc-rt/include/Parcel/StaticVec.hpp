@@ -98,6 +98,12 @@ namespace hc::parcel {
       this->__size = NN;
     }
 
+    void __setCap(usize N) {
+      const auto NN = static_cast<SizeType>(N);
+      __hc_assert(this->__size <= NN);
+      this->__cap = NN;
+    }
+
   public:
     SizeType __size, __cap;
   };
@@ -128,6 +134,7 @@ namespace hc::parcel {
     using CapBase::__growBy;
     using CapBase::__shrinkBy;
     using CapBase::__setSize;
+    using CapBase::__setCap;
   private:
     using CapBase::SizeTypeMax;
     using PtrBase::__first_elem;
@@ -487,7 +494,8 @@ namespace hc::parcel {
     }
 
     constexpr void clear() __noexcept {
-      return this->__destroy();
+      this->__destroy();
+      this->__setSize(0);
     }
   
   protected:
@@ -587,8 +595,10 @@ namespace hc::parcel {
       return SelfType::__capacity;
     }
 
+    /// Uses the current capacity, which is larger than `Capacity()`
+    /// once a `GrowableVec` spills.
     constexpr usize remainingCapacity() const __noexcept {
-      return Capacity() - this->size();
+      return usize(this->__remainingCapacity());
     }
   
   private:
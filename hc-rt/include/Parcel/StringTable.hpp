@@ -23,22 +23,42 @@
 
 #pragma once
 
+#include <Common/Limits.hpp>
 #include <Common/Pair.hpp>
 #include <Common/StrRef.hpp>
+#include <Parcel/GrowableVec.hpp>
 #include <Parcel/StaticVec.hpp>
 
 namespace hc::parcel {
   /// Stores strings as `[Offset, Length]`.
-  struct [[gnu::packed, clang::trivial_abi]] StrTblIdx {
-    u16 offset = 0;
-    u16 length = 0;
+  template <typename IntType>
+  struct [[gnu::packed, clang::trivial_abi]] BasicStrTblIdx {
+    static_assert(meta::is_unsigned<IntType>);
+    IntType offset = 0;
+    IntType length = 0;
+  };
+
+  /// The default 4-byte index, limited to 64KiB of character data.
+  using StrTblIdx = BasicStrTblIdx<u16>;
+  /// The 8-byte index, for tables with up to 4GiB of character data.
+  using WideStrTblIdx = BasicStrTblIdx<u32>;
+
+  /// Key used by the search accelerator. Ordered by `length`, then
+  /// `prefix`, which holds the first 8 bytes in big-endian order.
+  struct StrTblSearchKey {
+    u64 prefix = 0;
+    u32 length = 0;
+    u32 rank   = 0; // The position in the sorted table.
   };
 
   /// Base for string tables. Uses the buffer as a bump allocator, 
   /// which means generally strings cannot be removed once added.
   /// The main exception is `pop_back`, which is allowed if not dirty.
   /// On the other hand, table elements *can* be sorted and removed.
-  struct [[gsl::Pointer]] IStringTable {
+  /// @tparam IntType The type used for offsets and lengths.
+  template <typename IntType>
+  struct [[gsl::Pointer]] BasicIStringTable {
+    using IdxType = BasicStrTblIdx<IntType>;
     struct Iterator {
       using difference_type = uptrdiff;
       using value_type = com::StrRef;
@@ -58,14 +78,20 @@ namespace hc::parcel {
     private:
       value_type resolve() const;
     public:
-      const IStringTable* __base  = nullptr;
-      const StrTblIdx* __iter_val = nullptr;
+      const BasicIStringTable* __base  = nullptr;
+      const IdxType* __iter_val = nullptr;
     };
 
   public:
-    using SelfType   = IStringTable;
+    using SelfType   = BasicIStringTable;
+    using OffsetType = IntType;
     using BufferType = IStaticVec<char>;
-    using TableType  = IStaticVec<StrTblIdx>;
+    using TableType  = IStaticVec<IdxType>;
+    using HashType   = com::PtrRange<IdxType>;
+    using AccelType  = com::PtrRange<StrTblSearchKey>;
+    /// Set by tables with growable storage. Makes space for `strs`
+    /// more strings and `chars` more bytes, or returns `false`.
+    using GrowFn = bool(*)(SelfType& T, usize strs, usize chars);
 
     struct DataFlags {
       bool null_term    : 1; // Strings should be null-terminated.
@@ -76,6 +102,7 @@ namespace hc::parcel {
       bool is_sorted    : 1; // `true` when still known to be sorted.
       bool imp_empty    : 1; // If empty values should be implicit.
       bool has_empty    : 1; // If the table "contains" the empty string.
+      bool accel_stale  : 1; // The search accelerator must be rebuilt.
     };
 
     enum class Status {
@@ -89,22 +116,24 @@ namespace hc::parcel {
       = com::StrRef::New(nullptr, usize(0));
 
   public:
-    constexpr IStringTable(
-      BufferType& buf, TableType& tbl) :
-     buf(&buf), tbl(&tbl) {
+    constexpr BasicIStringTable(
+      BufferType& buf, TableType& tbl,
+      IdxType* hsh = nullptr, usize hsh_size = 0) :
+     buf(&buf), tbl(&tbl), hsh(HashType::New(hsh, hsh_size)) {
       this->flags.is_sorted = true;
       // TODO: Remove when complete.
       this->flags.imp_empty = true;
     }
   
   public:
-    static StrTblIdx GetEmptyIdx();
-    static bool IsEmptyIdx(StrTblIdx I);
+    static IdxType GetEmptyIdx();
+    static bool IsEmptyIdx(IdxType I);
 
     /// Attempts to add a new string to the table. Normally this
     /// will always append the string, even if it already exists.
     /// But when `flags::ksorted` is true, it will do a binary search to
     /// see if the element already exists. If not, it will be appended.
+    /// Hashed tables always check the index first, so are never duplicated.
     /// @return A pair with a span over the inserted string or the
     /// existing string, and a `Status`.
     com::Pair<com::StrRef, Status> insert(com::StrRef S);
@@ -147,11 +176,18 @@ namespace hc::parcel {
     //==================================================================//
 
     /// Sorts strings in lexicographic order, in shortlex form.
-    /// This is *usually* done using the introsort algorithm (TODO). 
+    /// This is done using insertion sort, or introsort when
+    /// `HC_FAST_STRING_TABLE` is on.
+    /// When `HC_RADIX_STRING_TABLE` is on, MSD radix sort is used instead.
     /// Sorting will set the dirty bit, which can be undone using `unsort`.
     /// @param keep_sorted Whether to sort newly inserted elements.
     void shortlexSort(bool keep_sorted = false);
 
+    /// Same as `shortlexSort`, but allows the radix sorter to use
+    /// `scratch` instead of sorting in place. Ignored by other sorters.
+    /// @param scratch Cleared after use, needs `size()` capacity.
+    void shortlexSort(TableType& scratch, bool keep_sorted = false);
+
     /// Reverts to insertion order, unsets dirty bit.
     /// It also sets `ksorted` to false.
     void unsort();
@@ -161,9 +197,23 @@ namespace hc::parcel {
       return *this;
     }
 
+    /// Attaches an Eytzinger-ordered copy of the sorted keys, which is
+    /// used by `locateString` to avoid touching `buf` on most probes.
+    /// Only used with `size() + 1` keys. Mutations mark it stale, it is
+    /// rebuilt by `shortlexSort` or `rebuildSearchAccelerator`.
+    void attachSearchAccelerator(AccelType keys) {
+      this->accel = keys;
+      (void) this->rebuildSearchAccelerator();
+    }
+
+    /// Lays out the attached keys again, if the table is sorted.
+    /// @return `true` if lookups use the accelerator.
+    bool rebuildSearchAccelerator();
+
     void clear() __noexcept {
       buf->clear();
       tbl->clear();
+      this->hashClear();
       // Unset flags
       flags.dirty = false;
       flags.is_sorted = true;
@@ -222,21 +272,43 @@ namespace hc::parcel {
         && !this->isSorted();
     }
 
+    /// @return `true` if a hash index is attached to the table.
+    bool isHashed() const { return hsh.__begin != nullptr; }
+
+    /// @return `true` if the search accelerator is current.
+    bool isAccelerated() const {
+      return !flags.accel_stale && (accel.size() > tbl->size());
+    }
+
     bool isDestructivePop() const {
       return (!tbl->isEmpty())
         && this->isSorted()
         && flags.destructive;
     }
 
-    bool isInlineEmpty(StrTblIdx I) const {
+    bool isInlineEmpty(IdxType I) const {
       return (!flags.imp_empty)
-        && IStringTable::IsEmptyIdx(I);
+        && BasicIStringTable::IsEmptyIdx(I);
     }
 
     bool doesNeedImplicitEmpty() const {
       return flags.imp_empty && flags.has_empty;
     }
 
+    /// Writes a relocatable image of the table to `out`, which can be
+    /// read with `FrozenStringTable`. The table must be sorted.
+    /// @return The bytes written, or `0` on failure. If `out` is null,
+    /// returns the required size instead.
+    usize freeze(com::PtrRange<u8> out) const;
+
+    /// Same as `locateString`, but resolves every string in `keys` with
+    /// one merge-style walk over the sorted table. Results are written to
+    /// `out` in the same order as `keys`. Uses stack space for sorting.
+    /// @param presorted If `keys` are already in shortlex order.
+    /// @return The number of strings which were found.
+    usize locateMany(com::ImmPtrRange<com::StrRef> keys,
+      com::PtrRange<com::StrRef> out, bool presorted = false) const;
+
   protected:
     /// Returns an empty string for the current null termination strategy.
     static com::StrRef GetEmptyString() {
@@ -248,11 +320,11 @@ namespace hc::parcel {
     /// Returns a `StrRef` from an index table index.
     com::StrRef resolveAt(usize Ix) const;
     /// Returns a `StrRef` from an index.
-    com::StrRef resolveDirect(StrTblIdx I) const;
+    com::StrRef resolveDirect(IdxType I) const;
 
     /// Returns the associated string in the table for `S`, if found.
     /// If permissive `isSorted` is `false`, or the string is not found,
-    /// `invalidString` will be returned.
+    /// `invalidString` will be returned. Hashed tables ignore ordering.
     com::StrRef locateString(com::StrRef S) const;
 
     /// Checks if the table has storage for the requested string.
@@ -261,13 +333,17 @@ namespace hc::parcel {
     bool doesHaveStorageFor(com::StrRef S) const;
   
   private:
+    /// Same as `doesHaveStorageFor`, but grows the storage if possible.
+    /// Called before any pointers are taken, since growing relocates.
+    bool reserveFor(com::StrRef S);
+
     /// Adds a string to the back of the table.
     /// Assumes `.dropNull()` has been called.
     com::StrRef appendDirect(com::StrRef S);
 
     /// Adds a string to the back of the table.
     /// Assumes `.dropNull()` has been called.
-    StrTblIdx appendDirectIter(com::StrRef S);
+    IdxType appendDirectIter(com::StrRef S);
 
     /// Inserts a string into a sorted array without adding index.
     /// Assumes `.dropNull()` has been called.
@@ -279,26 +355,131 @@ namespace hc::parcel {
     /// Internal binary search algo. Same rules as `locateString`.
     com::StrRef binarySearch(com::StrRef S) const;
 
+    //==================================================================//
+    // Hash Index
+    //==================================================================//
+
+    /// Returns the slot holding `S`, or the empty slot it would use.
+    /// Assumes the table is hashed, and `S` is not empty.
+    IdxType* hashProbe(com::StrRef S) const;
+
+    /// Looks up `S` in the hash index. Returns `invalidString` on failure.
+    com::StrRef hashSearch(com::StrRef S) const;
+
+    /// Adds a new index to the hash index. Assumes it isn't present.
+    void hashInsert(IdxType I);
+
+    /// Removes an index from the hash index, backshifting the chain.
+    void hashErase(IdxType I);
+
+    /// Resets every slot in the hash index.
+    void hashClear();
+
+    //==================================================================//
+    // Search Accelerator
+    //==================================================================//
+
+    /// Marks the layout stale, called after every mutation.
+    void accelInvalidate() {
+      this->flags.accel_stale = true;
+    }
+
+    /// Lays out the sorted keys in Eytzinger order.
+    void accelRebuild();
+
+    /// In-order fill of the subtree at `K`, starting at rank `Ix`.
+    /// @return The next rank to be placed.
+    usize accelBuild(usize Ix, usize K);
+
+    /// Same rules as `binarySearch`.
+    com::StrRef accelSearch(com::StrRef S) const;
+
   protected:
     BufferType* buf  = nullptr;
     TableType*  tbl  = nullptr;
+    HashType    hsh  = {};
+    AccelType   accel = {};
+    GrowFn      grow  = nullptr;
     DataFlags flags  = {};
   };
 
+  using IStringTable = BasicIStringTable<u16>;
+  using WideIStringTable = BasicIStringTable<u32>;
+
+  extern template struct BasicIStringTable<u16>;
+  extern template struct BasicIStringTable<u32>;
+
   //====================================================================//
   // Table Implementation
   //====================================================================//
 
+  /// @tparam HashSlots When non-zero, attaches an open-addressed index
+  /// which is used for deduplication and lookup instead of sorting.
+  template <typename IntType,
+    usize BufferSize, usize TableSize, usize HashSlots = 0>
+  struct [[gsl::Owner]] BasicStringTable : BasicIStringTable<IntType> {
+    static_assert((HashSlots & (HashSlots - 1)) == 0,
+      "HashSlots must be a power of 2.");
+    static_assert((HashSlots == 0) || (HashSlots > TableSize),
+      "HashSlots must be greater than TableSize.");
+    // The maximum value is reserved for empty offsets.
+    static_assert(BufferSize <= usize(Max<IntType>),
+      "BufferSize is too large for the offset type.");
+    using BaseType = BasicIStringTable<IntType>;
+    using SelfType = BasicStringTable;
+    using IdxType  = BasicStrTblIdx<IntType>;
+  public:
+    constexpr BasicStringTable() :
+     BaseType(__buf, __tbl, __hsh.__data(), HashSlots) {}
+    
+    /// Disable copying and moving.
+    HC_MARK_DELETED(BasicStringTable);
+    
+    BaseType* operator->() {
+      return static_cast<BaseType*>(this);
+    }
+    const BaseType* operator->() const {
+      return static_cast<const BaseType*>(this);
+    }
+
+  private:
+    StaticVec<char, BufferSize>    __buf;
+    StaticVec<IdxType, TableSize> __tbl;
+    StaticVecStorage<IdxType, HashSlots> __hsh {};
+  };
+
+  template <usize BufferSize, usize TableSize, usize HashSlots = 0>
+  using StringTable = BasicStringTable<
+    u16, BufferSize, TableSize, HashSlots>;
+
+  /// A `StringTable` which allows for over 64KiB of character data.
+  template <usize BufferSize, usize TableSize, usize HashSlots = 0>
+  using WideStringTable = BasicStringTable<
+    u32, BufferSize, TableSize, HashSlots>;
+
+  /// A `StringTable` with a hash index twice the size of the table.
   template <usize BufferSize, usize TableSize>
-  struct [[gsl::Owner]] StringTable : IStringTable {
-    using BaseType = IStringTable;
-    using SelfType = StringTable;
+  using HashedStringTable = StringTable<
+    BufferSize, TableSize, com::Align::Up(TableSize * 2 - 1)>;
+
+  /// Table which starts with inline storage, and spills into `ArenaType`
+  /// when full. Spilling relocates the buffer, so previously returned
+  /// `StrRef`s are invalidated. Lookups will still work as expected.
+  template <typename IntType, usize BufferSize, usize TableSize,
+    typename ArenaType = VecArena<>>
+  struct [[gsl::Owner]] BasicGrowableStringTable
+   : BasicIStringTable<IntType> {
+    using BaseType = BasicIStringTable<IntType>;
+    using SelfType = BasicGrowableStringTable;
+    using IdxType  = BasicStrTblIdx<IntType>;
   public:
-    constexpr StringTable() :
-     IStringTable(__buf, __tbl) {}
+    constexpr BasicGrowableStringTable(ArenaType& arena) :
+     BaseType(__buf, __tbl), __buf(arena), __tbl(arena) {
+      this->grow = &SelfType::Grow;
+    }
     
     /// Disable copying and moving.
-    HC_MARK_DELETED(StringTable);
+    HC_MARK_DELETED(BasicGrowableStringTable);
     
     BaseType* operator->() {
       return static_cast<BaseType*>(this);
@@ -308,8 +489,25 @@ namespace hc::parcel {
     }
 
   private:
-    StaticVec<char, BufferSize>      __buf;
-    StaticVec<StrTblIdx, TableSize> __tbl;
+    static bool Grow(BaseType& T, usize strs, usize chars) {
+      auto& self = static_cast<SelfType&>(T);
+      return self.__tbl.canGrowBy(strs)
+          && self.__buf.canGrowBy(chars);
+    }
+
+  private:
+    GrowableVec<char, BufferSize, ArenaType>    __buf;
+    GrowableVec<IdxType, TableSize, ArenaType> __tbl;
   };
 
+  template <usize BufferSize, usize TableSize,
+    typename ArenaType = VecArena<>>
+  using GrowableStringTable = BasicGrowableStringTable<
+    u16, BufferSize, TableSize, ArenaType>;
+
+  template <usize BufferSize, usize TableSize,
+    typename ArenaType = VecArena<>>
+  using WideGrowableStringTable = BasicGrowableStringTable<
+    u32, BufferSize, TableSize, ArenaType>;
+
 } // namespace hc::parcel
@@ -0,0 +1,52 @@
+//===- Parcel/_BitOps.hpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Bulk kernels over packed bit words. These use the widest available
+//  vector type, and are used by BitList and BitSet at runtime.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "_BitRef.hpp"
+
+namespace hc::parcel {
+  struct BitOps {
+    using WordType = BitListType;
+  public:
+    /// `dst[I] &= src[I]` for each of the `len` words.
+    static void And(WordType* dst, const WordType* src, usize len);
+    /// `dst[I] |= src[I]` for each of the `len` words.
+    static void Or(WordType* dst, const WordType* src, usize len);
+    /// `dst[I] ^= src[I]` for each of the `len` words.
+    static void Xor(WordType* dst, const WordType* src, usize len);
+    /// `dst[I] &= ~src[I]` for each of the `len` words.
+    static void AndNot(WordType* dst, const WordType* src, usize len);
+
+    /// @return The number of set bits in the `len` words.
+    static usize Count(const WordType* src, usize len);
+
+    /// @return The first set bit at or after `from`, or `-1`.
+    static isize FindNext(const WordType* src, usize len, usize from);
+
+    /// Sets the bits in `[begin, end)`.
+    static void SetRange(WordType* dst, usize begin, usize end);
+    /// Clears the bits in `[begin, end)`.
+    static void ClearRange(WordType* dst, usize begin, usize end);
+  };
+} // namespace hc::parcel
@@ -0,0 +1,120 @@
+//===- Common/Arena.cpp ---------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include <Common/Arena.hpp>
+#include <Common/Lifetime.hpp>
+
+using namespace hc;
+using namespace hc::common;
+
+Arena::Arena(AddrRange initial, PageProvider pages) : __pages(pages) {
+  if (initial.data() != nullptr)
+    (void) this->addChunk(initial, false);
+}
+
+Arena::~Arena() {
+  ArenaChunk* C = __head;
+  while (C != nullptr) {
+    ArenaChunk* const next = C->next;
+    if (C->block.data() != nullptr)
+      __pages.release(C->block);
+    C = next;
+  }
+}
+
+bool Arena::addChunk(AddrRange block, bool owned) {
+  const uptr base = uptr(block.data());
+  const uptr end  = base + block.size();
+  const uptr P = (base + (alignof(ArenaChunk) - 1))
+    & ~uptr(alignof(ArenaChunk) - 1);
+  if __expect_false(!base || P + sizeof(ArenaChunk) >= end)
+    return false;
+
+  auto* const C = common::construct_at(
+    reinterpret_cast<ArenaChunk*>(P));
+  C->size = end - (P + sizeof(ArenaChunk));
+  if (owned)
+    C->block = block;
+
+  if (__tail)
+    this->__tail->next = C;
+  else
+    this->__head = C;
+  this->__tail = C;
+  if (!__curr) {
+    this->__curr = C;
+    this->__offset = 0;
+  }
+  return true;
+}
+
+/// Bumps the offset in `C`.
+/// @return The block, or `nullptr` if it doesn't fit.
+static void* bump_chunk(ArenaChunk* C, usize& offset,
+ usize size, usize align) {
+  const uptr base = uptr(C->data());
+  const uptr P = (base + offset + (align - 1)) & ~uptr(align - 1);
+  if (P < base || P + size < P || P + size > uptr(C->end()))
+    return nullptr;
+  offset = (P + size) - base;
+  return reinterpret_cast<void*>(P);
+}
+
+void* Arena::allocateSlow(usize size, usize align) {
+  ArenaChunk* const old_curr = __curr;
+  const usize old_offset = __offset;
+
+  // Try the chunks kept after a rewind.
+  for (ArenaChunk* C = __curr ? __curr->next : nullptr; C; C = C->next) {
+    usize offset = 0;
+    if (void* P = bump_chunk(C, offset, size, align)) {
+      this->__curr = C;
+      this->__offset = offset;
+      return P;
+    }
+  }
+
+  // Request more pages, growing geometrically.
+  const usize overhead = sizeof(ArenaChunk) + alignof(ArenaChunk) + align;
+  if __expect_false(!__pages.isValid() || size > Max<usize> - overhead)
+    return nullptr;
+  usize want = size + overhead;
+  if (want < minChunkSize)
+    want = minChunkSize;
+  if (__tail && __tail->block.data() && want < __tail->size * 2)
+    want = __tail->size * 2;
+
+  const AddrRange block = __pages.allocate(want);
+  if __expect_false(block.data() == nullptr)
+    return nullptr;
+  if __expect_false(!this->addChunk(block, true)) {
+    __pages.release(block);
+    return nullptr;
+  }
+
+  usize offset = 0;
+  if (void* P = bump_chunk(__tail, offset, size, align)) {
+    this->__curr = __tail;
+    this->__offset = offset;
+    return P;
+  }
+  // The provider gave us less than we asked for.
+  this->__curr = old_curr;
+  this->__offset = old_offset;
+  return nullptr;
+}
@@ -0,0 +1,165 @@
+//===- Common/CpuFeatures.cpp ---------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "CpuFeatures.hpp"
+#include <Sys/Atomic.hpp>
+
+using namespace hc;
+using namespace hc::rt;
+
+namespace {
+  // XCR0 components.
+  constexpr u64 __xcr0_sse    = 0x02;
+  constexpr u64 __xcr0_avx    = 0x04 | __xcr0_sse;
+  constexpr u64 __xcr0_avx512 = 0xE0 | __xcr0_avx;
+
+  // Where `rep movsb/stosb` start to beat the block loops, it needs
+  // less setup with FSRM. Rerun `hc-kernel-bench --strategies` on the
+  // target hardware before changing these.
+  //
+  // On an ERMS + FSRM Xeon (family 6, model 207), both string ops
+  // lose to the 32 byte loops up to 1280 bytes (0.0195 vs 0.0191
+  // cycles/byte for the copy), and win from 1408 bytes (0.0181 vs
+  // 0.0190) up through 64 MiB. `rep stosb` is kept at 0x800, as it
+  // has no FSRM fast path and ERMS only parts start later. The ERMS
+  // only values haven't been measured yet.
+  constexpr usize __rep_movsb_fsrm = 0x600;
+  constexpr usize __rep_movsb_erms = 0x800;
+  constexpr usize __rep_stosb_erms = 0x800;
+  static_assert(__rep_movsb_fsrm >= __rep_string_floor);
+  static_assert(__rep_movsb_erms >= __rep_string_floor);
+  static_assert(__rep_stosb_erms >= __rep_string_floor);
+
+  // Leaf 0 vendor strings, "GenuineIntel" and "AuthenticAMD".
+  constexpr u32 __vendor_intel = 0x756E6547;
+  constexpr u32 __vendor_amd   = 0x68747541;
+
+  __always_inline bool __has_bit(u32 reg, u32 bit) {
+    return (reg >> bit) & 0x1;
+  }
+
+  /// Walks the deterministic cache parameters (leaf `4` on Intel,
+  /// `0x8000001D` on AMD) and returns the largest data cache.
+  u64 __walk_cache_leaf(u32 leaf) {
+    u64 largest = 0;
+    for (u32 sub = 0; sub < 16; ++sub) {
+      const CpuidRegs R = __cpuid(leaf, sub);
+      const u32 type = R.eax & 0x1F;
+      if (type == 0)
+        break;
+      // Skip instruction caches.
+      if (type == 2)
+        continue;
+      const u64 ways  = u64(R.ebx >> 22) + 1;
+      const u64 parts = u64((R.ebx >> 12) & 0x3FF) + 1;
+      const u64 line  = u64(R.ebx & 0xFFF) + 1;
+      const u64 sets  = u64(R.ecx) + 1;
+      const u64 size  = ways * parts * line * sets;
+      if (size > largest)
+        largest = size;
+    }
+    return largest;
+  }
+
+  u64 __probe_llc_size(u32 vendor, u32 max_leaf) {
+    if (vendor == __vendor_intel && max_leaf >= 4)
+      return __walk_cache_leaf(4);
+    const u32 max_ext = __cpuid(0x80000000).eax;
+    if (vendor == __vendor_amd && max_ext >= 0x8000001D) {
+      // Requires TOPOEXT.
+      if (__has_bit(__cpuid(0x80000001).ecx, 22))
+        return __walk_cache_leaf(0x8000001D);
+    }
+    if (max_ext >= 0x80000006) {
+      // Legacy L2/L3 descriptors, in KiB and 512 KiB units.
+      const CpuidRegs R = __cpuid(0x80000006);
+      if (const u64 l3 = (R.edx >> 18); l3 != 0)
+        return l3 * 0x80000;
+      return u64(R.ecx >> 16) * 0x400;
+    }
+    return 0;
+  }
+} // namespace `anonymous`
+
+CpuFeatures CpuFeatures::Probe() {
+  CpuFeatures F {};
+  const CpuidRegs L0 = __cpuid(0);
+  F.max_leaf = L0.eax;
+  if __expect_false(F.max_leaf < 1)
+    return F;
+
+  const CpuidRegs L1 = __cpuid(1);
+  F.sse2    = __has_bit(L1.edx, 26);
+  F.sse42   = __has_bit(L1.ecx, 20);
+  F.osxsave = __has_bit(L1.ecx, 27);
+  if (F.osxsave)
+    F.xcr0 = __xgetbv(0);
+
+  // The CPU may support AVX while the OS doesn't save the registers.
+  const bool os_avx    = (F.xcr0 & __xcr0_avx) == __xcr0_avx;
+  const bool os_avx512 = (F.xcr0 & __xcr0_avx512) == __xcr0_avx512;
+  F.avx = __has_bit(L1.ecx, 28) && os_avx;
+
+  if (F.max_leaf >= 7) {
+    const CpuidRegs L7 = __cpuid(7, 0);
+    F.avx2     = __has_bit(L7.ebx, 5) && F.avx;
+    F.bmi2     = __has_bit(L7.ebx, 8);
+    F.avx512f  = __has_bit(L7.ebx, 16) && os_avx512;
+    F.avx512bw = __has_bit(L7.ebx, 30) && os_avx512;
+    F.erms     = __has_bit(L7.ebx, 9);
+    F.fsrm     = __has_bit(L7.edx, 4);
+  }
+
+  if (F.avx512f && F.avx512bw)
+    F.tier = CpuTier::AVX512;
+  else if (F.avx2)
+    F.tier = CpuTier::AVX2;
+  else if (F.sse2)
+    F.tier = CpuTier::SSE2;
+
+  F.llc_size = __probe_llc_size(L0.ebx, F.max_leaf);
+  if (F.erms) {
+    F.rep_movsb_threshold = F.fsrm
+      ? __rep_movsb_fsrm : __rep_movsb_erms;
+    F.rep_stosb_threshold = __rep_stosb_erms;
+  }
+
+#if RT_NONTEMPORAL_DIV
+  if (F.llc_size != 0)
+    F.nt_threshold = usize(F.llc_size / RT_NONTEMPORAL_DIV);
+#endif
+  return F;
+}
+
+constinit CpuFeatures rt::__cpu_features {};
+constinit sys::Atomic<u8> rt::__cpu_probe_state {};
+
+const CpuFeatures& rt::__probe_cpu_features() {
+  using enum sys::MemoryOrder;
+  u8 expected = u8(CpuProbeState::Unprobed);
+  if (__cpu_probe_state.cmpxchg(expected,
+   u8(CpuProbeState::Probing), Acquire, Acquire)) {
+    __cpu_features = CpuFeatures::Probe();
+    // Publishes the struct, nothing reads it before this.
+    __cpu_probe_state.store(u8(CpuProbeState::Ready), Release);
+    return __cpu_features;
+  }
+  while (__cpu_probe_state.load(Acquire) != u8(CpuProbeState::Ready))
+    __builtin_ia32_pause();
+  return __cpu_features;
+}
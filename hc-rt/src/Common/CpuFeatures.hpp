@@ -0,0 +1,155 @@
+//===- Common/CpuFeatures.hpp ---------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Runtime CPU feature detection. `SSEVec.hpp` picks vector widths
+//  at compile time, this is used to pick kernels at runtime instead.
+//  A feature only counts if the OS also saves its state (XCR0).
+//  The last level cache size is read from the cache parameter leaves.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Fundamental.hpp>
+#include <Common/Limits.hpp>
+#include <Sys/Atomic.hpp>
+
+/// Non-temporal stores are used above `LLC / RT_NONTEMPORAL_DIV`.
+/// Setting it to `0` disables them. `hc-kernel-bench --strategies`
+/// prints the divisor matching the crossover on the host.
+///
+/// On a Xeon (family 6, model 207) reporting a 300 MiB LLC, streaming
+/// fills lose to `rep stosb` at 128 MiB and win from 192 MiB, which
+/// is `2`. Streaming copies never beat `rep movsb` up to 1 GiB (within
+/// 2% from 384 MiB, 24% slower at 192 MiB), so with ERMS they only pay
+/// off by keeping the cache for other work.
+#ifndef RT_NONTEMPORAL_DIV
+# define RT_NONTEMPORAL_DIV 2
+#endif
+
+namespace hc::rt {
+  struct CpuidRegs {
+    u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+  };
+
+  /// The widest kernel set the current CPU can run.
+  enum class CpuTier : u8 {
+    Generic,
+    SSE2,
+    AVX2,
+    AVX512,
+  };
+
+  struct CpuFeatures {
+    u32 max_leaf = 0;
+    /// The state components enabled by the OS.
+    u64 xcr0 = 0;
+    bool sse2     : 1 = false;
+    bool sse42    : 1 = false;
+    bool osxsave  : 1 = false;
+    bool avx      : 1 = false;
+    bool avx2     : 1 = false;
+    bool bmi2     : 1 = false;
+    bool avx512f  : 1 = false;
+    bool avx512bw : 1 = false;
+    /// Enhanced `rep movsb`/`rep stosb`.
+    bool erms     : 1 = false;
+    /// Fast short `rep movsb`.
+    bool fsrm     : 1 = false;
+    CpuTier tier = CpuTier::Generic;
+    /// The size of the last level cache, `0` if unknown.
+    u64 llc_size = 0;
+    /// The size where copies and fills start streaming.
+    usize nt_threshold = Max<usize>;
+    /// The sizes where string instructions beat the block loops.
+    usize rep_movsb_threshold = Max<usize>;
+    usize rep_stosb_threshold = Max<usize>;
+  public:
+    /// Runs the probe, doesn't touch the cache.
+    static CpuFeatures Probe();
+  };
+
+  __always_inline CpuidRegs __cpuid(u32 leaf, u32 subleaf = 0) {
+    CpuidRegs R;
+    __asm__ volatile ("cpuid"
+      : "=a"(R.eax), "=b"(R.ebx), "=c"(R.ecx), "=d"(R.edx)
+      : "a"(leaf), "c"(subleaf));
+    return R;
+  }
+
+  /// Only valid when `osxsave` is set.
+  __always_inline u64 __xgetbv(u32 xcr) {
+    u32 lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(xcr));
+    return (u64(hi) << 32) | lo;
+  }
+
+  enum class CpuProbeState : u8 {
+    Unprobed,
+    Probing,
+    Ready,
+  };
+
+  /// Only read once `__cpu_probe_state` is `Ready`.
+  extern constinit CpuFeatures __cpu_features;
+  extern constinit sys::Atomic<u8> __cpu_probe_state;
+
+  /// Fills `__cpu_features` exactly once, then returns it.
+  /// Threads that lose the race wait for the winner.
+  const CpuFeatures& __probe_cpu_features();
+
+  /// Probes once, then returns the cached features.
+  /// Inline, since the large copy paths check it on every call.
+  __always_inline const CpuFeatures& cpu_features() {
+    const auto state = __cpu_probe_state.load(sys::MemoryOrder::Acquire);
+    if __expect_true(state == u8(CpuProbeState::Ready))
+      return __cpu_features;
+    return __probe_cpu_features();
+  }
+
+  __always_inline CpuTier cpu_tier() {
+    return cpu_features().tier;
+  }
+
+  /// Anything smaller is assumed to fit in the LLC,
+  /// so the probe can be skipped.
+  inline constexpr usize __nontemporal_floor = 0x40000;
+
+  __always_inline bool __use_nontemporal(usize len) {
+    if __expect_true(len < __nontemporal_floor)
+      return false;
+    return len >= cpu_features().nt_threshold;
+  }
+
+  /// The smallest threshold the probe picks, so smaller sizes
+  /// skip the probe entirely.
+  inline constexpr usize __rep_string_floor = 0x600;
+
+  /// Streaming is checked first, so this only has to cover the bottom.
+  __always_inline bool __use_rep_movsb(usize len) {
+    if __expect_true(len < __rep_string_floor)
+      return false;
+    return len >= cpu_features().rep_movsb_threshold;
+  }
+
+  __always_inline bool __use_rep_stosb(usize len) {
+    if __expect_true(len < __rep_string_floor)
+      return false;
+    return len >= cpu_features().rep_stosb_threshold;
+  }
+} // namespace hc::rt
@@ -24,11 +24,10 @@
 #pragma once
 
 #include <Common/Features.hpp>
+#include "CpuFeatures.hpp"
 #include "IAlign.hpp"
 #include "Prefetching.hpp"
 
-// TODO: Use prefetching/SIMD?
-
 #define _HC_MEMCPY_FN(name) \
  static inline void name(u8* __restrict dst, \
   const u8* __restrict src, [[maybe_unused]] usize len = 0)
@@ -68,6 +67,37 @@ namespace hc::rt {
     $tail_return __copy_last_block<BlockSize>(dst, src, len);
   }
 
+  /// Copies with non-temporal stores, so huge copies don't evict
+  /// the cache. Expects `len` to be well over two cache lines.
+  template <typename VecType = Gv128>
+  _HC_MEMCPY_FN(__copy_nontemporal) {
+    static constexpr usize kLine = cacheLinesSize<1>;
+    static constexpr usize prefetchDist = cacheLinesSize<8>;
+    // Copy the head normally, then stream from the next line.
+    __copy_block<kLine>(dst, src);
+    const usize skip = kLine - (uptr(dst) & (kLine - 1U));
+    u8* D = dst + skip;
+    const u8* S = src + skip;
+    usize rem = len - skip;
+    for (; rem >= kLine; rem -= kLine, D += kLine, S += kLine) {
+      smart_prefetch<PrefetchMode::Read, Locality::None>(S + prefetchDist);
+      for (usize off = 0; off < kLine; off += sizeof(VecType)) {
+        __builtin_nontemporal_store(load<VecType>(S + off),
+          reinterpret_cast<VecType*>(D + off));
+      }
+    }
+    // Order the streamed stores before anything after the copy.
+    __builtin_ia32_sfence();
+    if (rem != 0)
+      $tail_return __copy_last_block<kLine>(dst, src, len);
+  }
+
+  /// Copies with `rep movsb`, only fast with ERMS.
+  _HC_MEMCPY_FN(__copy_rep_movsb) {
+    __asm__ volatile ("rep movsb"
+      : "+D"(dst), "+S"(src), "+c"(len) :: "memory");
+  }
+
   //====================================================================//
   // Implementation
   //====================================================================//
@@ -83,6 +113,10 @@ namespace hc::rt {
     $tail_return __copy_block<4>(dst, src, len);
   }
 
+#if _HC_TUNED_DISPATCH
+// Generated by `hc-dispatch-gen` from `HC_TUNE_HISTOGRAM`.
+# include <TunedMemcpy.inc>
+#else
   [[gnu::always_inline]] _HC_MEMCPY_FN(__memcpy_dispatch) {
     if (len == 0)
       return;
@@ -98,9 +132,14 @@ namespace hc::rt {
       $tail_return __copy_overlap_block<32>(dst, src, len);
     if (len < 128)
       $tail_return __copy_overlap_block<64>(dst, src, len);
+    if __expect_false(__use_nontemporal(len))
+      $tail_return __copy_nontemporal(dst, src, len);
+    if (__use_rep_movsb(len))
+      $tail_return __copy_rep_movsb(dst, src, len);
     // else:
     $tail_return __copy_aligned_blocks<32>(dst, src, len);
   }
+#endif // _HC_TUNED_DISPATCH
 } // namespace hc::rt
 
 namespace hc::common {
@@ -0,0 +1,125 @@
+//===- Common/InlineMemmove.hpp -------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Underlying implementation of the memmove equivelent.
+//  Small sizes load every block before storing, so overlap is free.
+//  Larger sizes loop forwards or backwards depending on the overlap.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "InlineMemcpy.hpp"
+
+#define _HC_MEMMOVE_FN(name) \
+ static inline void name(u8* dst, \
+  const u8* src, [[maybe_unused]] usize len = 0)
+
+namespace hc::rt {
+  /// The block size used by the loops.
+  inline constexpr usize __memmove_block_v
+    = (__vector_size_v > 16) ? __vector_size_v : 16;
+
+  template <usize BlockSize>
+  struct __move_block {
+    __always_inline void load(const u8* src) {
+      __builtin_memcpy_inline(__data, src, BlockSize);
+    }
+    __always_inline void store(u8* dst) const {
+      __builtin_memcpy_inline(dst, __data, BlockSize);
+    }
+  public:
+    alignas(BlockSize) u8 __data[BlockSize];
+  };
+
+  /// Copies `BlockSize <= len <= BlockSize * 2` bytes.
+  template <usize BlockSize>
+  _HC_MEMMOVE_FN(__move_overlap_block) {
+    __move_block<BlockSize> head, tail;
+    head.load(src);
+    tail.load(src + len - BlockSize);
+    head.store(dst);
+    tail.store(dst + len - BlockSize);
+  }
+
+  /// Used when `dst` is before `src`, or they don't overlap.
+  template <usize BlockSize>
+  _HC_MEMMOVE_FN(__move_blocks_fwd) {
+    // The loop may overwrite the source tail, so load it first.
+    __move_block<BlockSize> tail, curr;
+    tail.load(src + len - BlockSize);
+    for (usize off = 0; off + BlockSize < len; off += BlockSize) {
+      curr.load(src + off);
+      curr.store(dst + off);
+    }
+    tail.store(dst + len - BlockSize);
+  }
+
+  /// Used when `dst` is after `src`.
+  template <usize BlockSize>
+  _HC_MEMMOVE_FN(__move_blocks_bwd) {
+    // The loop may overwrite the source head, so load it first.
+    __move_block<BlockSize> head, curr;
+    head.load(src);
+    for (usize off = len; off > BlockSize; off -= BlockSize) {
+      curr.load(src + off - BlockSize);
+      curr.store(dst + off - BlockSize);
+    }
+    head.store(dst);
+  }
+
+  //====================================================================//
+  // Implementation
+  //====================================================================//
+
+  [[gnu::always_inline]] _HC_MEMMOVE_FN(__memmove_dispatch) {
+    if (len < 2)
+      $tail_return __move_overlap_block<1>(dst, src, len);
+    if (len < 4)
+      $tail_return __move_overlap_block<2>(dst, src, len);
+    if (len < 8)
+      $tail_return __move_overlap_block<4>(dst, src, len);
+    if (len < 16)
+      $tail_return __move_overlap_block<8>(dst, src, len);
+    if (len < 32)
+      $tail_return __move_overlap_block<16>(dst, src, len);
+    if (len < 64)
+      $tail_return __move_overlap_block<32>(dst, src, len);
+    if (len <= 128)
+      $tail_return __move_overlap_block<64>(dst, src, len);
+    // else:
+    constexpr usize B = __memmove_block_v;
+    // True if `dst` is before `src`, or past the end of it.
+    if ((uptr(dst) - uptr(src)) >= len)
+      $tail_return __move_blocks_fwd<B>(dst, src, len);
+    $tail_return __move_blocks_bwd<B>(dst, src, len);
+  }
+} // namespace hc::rt
+
+namespace hc::common {
+  static inline void inline_memmove(
+   void* dst, const void* src, usize len) {
+    __hc_invariant((dst && src) || !len);
+    if __expect_false(len == 0 || dst == src)
+      return;
+    return rt::__memmove_dispatch(
+      (u8*)dst, (const u8*)src, len);
+  }
+} // namespace hc::common
+
+#undef _HC_MEMMOVE_FN
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <Common/Array.hpp>
+#include "CpuFeatures.hpp"
 #include "IAlign.hpp"
 #include "Prefetching.hpp"
 
@@ -76,6 +77,33 @@ namespace hc::rt {
     return __set_loop_and_last_off<BlockType>(dst, val, len, 0);
   }
 
+  /// Fills with non-temporal stores, so huge fills don't evict
+  /// the cache. Expects `len` to be well over two cache lines.
+  template <typename VecType = Gv128>
+  _HC_MEMSET_FN(__set_nontemporal) {
+    static constexpr usize kLine = cacheLinesSize<1>;
+    const VecType V = splat<VecType>(val);
+    // Fill the head normally, then stream from the next line.
+    __set_block<v512>(dst, val);
+    const usize skip = kLine - (uptr(dst) & (kLine - 1U));
+    u8* D = dst + skip;
+    usize rem = len - skip;
+    for (; rem >= kLine; rem -= kLine, D += kLine) {
+      for (usize off = 0; off < kLine; off += sizeof(VecType))
+        __builtin_nontemporal_store(V, reinterpret_cast<VecType*>(D + off));
+    }
+    // Order the streamed stores before anything after the fill.
+    __builtin_ia32_sfence();
+    if (rem != 0)
+      $tail_return __set_last_block<v512>(dst, val, len);
+  }
+
+  /// Fills with `rep stosb`, only fast with ERMS.
+  _HC_MEMSET_FN(__set_rep_stosb) {
+    __asm__ volatile ("rep stosb"
+      : "+D"(dst), "+c"(len) : "a"(val) : "memory");
+  }
+
   //====================================================================//
   // Implementation
   //====================================================================//
@@ -117,6 +145,10 @@ namespace hc::rt {
     $tail_return __set_block<u32>(dst, val, len);
   }
 
+#if _HC_TUNED_DISPATCH
+// Generated by `hc-dispatch-gen` from `HC_TUNE_HISTOGRAM`.
+# include <TunedMemset.inc>
+#else
   [[gnu::always_inline]] static _HC_MEMSET_FN(__memset_dispatch) {
     if (len == 0)
       return;
@@ -130,15 +162,20 @@ namespace hc::rt {
       $tail_return __set_first_last_block<v128>(dst, val, len);
     if (len <= 64)
       $tail_return __set_first_last_block<v256>(dst, val, len);
-    if constexpr (__memset_prefetch_)
-      $tail_return __prefetching_memset(dst, val, len);
     if (len <= 128)
       $tail_return __set_first_last_block<v512>(dst, val, len);
+    if __expect_false(__use_nontemporal(len))
+      $tail_return __set_nontemporal(dst, val, len);
+    if (__use_rep_stosb(len))
+      $tail_return __set_rep_stosb(dst, val, len);
+    if constexpr (__memset_prefetch_)
+      $tail_return __prefetching_memset(dst, val, len);
     // else:
     __set_block<v256>(dst, val);
     align_to_next_boundary<32>(dst, len);
     $tail_return __set_loop_and_last<v256>(dst, val, len);
   }
+#endif // _HC_TUNED_DISPATCH
 } // namespace hc::rt
 
 namespace hc::common {
@@ -0,0 +1,37 @@
+//===- Common/Scratch.cpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include <Common/Scratch.hpp>
+
+using namespace hc;
+using namespace hc::common;
+
+namespace {
+  // Zero initialized, so it's reserved in `.tbss`.
+  alignas(64) thread_local u8 __scratch_buf_[ScratchStack::defaultSize];
+  thread_local constinit ScratchStack __scratch_ {};
+} // namespace `anonymous`
+
+ScratchStack& ScratchStack::Local() {
+  ScratchStack& S = __scratch_;
+  if __expect_false(S.__base == nullptr) {
+    S.__base = __scratch_buf_;
+    S.__size = sizeof(__scratch_buf_);
+  }
+  return S;
+}
@@ -0,0 +1,255 @@
+//===- Common/SlabAllocator.cpp -------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include <Common/SlabAllocator.hpp>
+#include <Common/Lifetime.hpp>
+#include <Common/Limits.hpp>
+#include <Sys/Locks.hpp>
+
+using namespace hc;
+using namespace hc::common;
+using Header = SlabHeader;
+
+//======================================================================//
+// Helpers
+//======================================================================//
+
+static void push_slab(Header*& head, Header* H) {
+  H->prev = nullptr;
+  H->next = head;
+  if (head)
+    head->prev = H;
+  head = H;
+}
+
+static void unlink_slab(Header*& head, Header* H) {
+  if (H->prev)
+    H->prev->next = H->next;
+  else
+    head = H->next;
+  if (H->next)
+    H->next->prev = H->prev;
+  H->next = nullptr;
+  H->prev = nullptr;
+}
+
+/// Claims the lowest free object in `H`.
+static void* take_object(Header* H) {
+  __hc_invariant(H->used < H->capacity);
+  for (usize W = H->hint; W < Header::bitWords; ++W) {
+    const u64 bits = H->bits[W];
+    if (bits == Max<u64>)
+      continue;
+    const usize Ix = (W * 64) + __builtin_ctzll(~bits);
+    if __expect_false(Ix >= H->capacity)
+      break;
+    H->bits[W] = bits | (u64(1) << (Ix % 64));
+    H->hint = u16(W);
+    ++H->used;
+    return reinterpret_cast<u8*>(H) + H->first
+      + (Ix * H->object_size);
+  }
+  __hc_unreachable("Slab bitmap is inconsistent.");
+}
+
+/// Releases the object at `P` in `H`.
+static void give_object(Header* H, void* P) {
+  const usize off = uptr(P) - uptr(H);
+  __hc_invariant(off >= H->first);
+  const usize Ix = (off - H->first) / H->object_size;
+  const usize W = Ix / 64;
+  const u64 mask = u64(1) << (Ix % 64);
+  __hc_invariant(Ix < H->capacity && (H->bits[W] & mask));
+  H->bits[W] &= ~mask;
+  if (W < H->hint)
+    H->hint = u16(W);
+  --H->used;
+}
+
+//======================================================================//
+// SlabAllocator
+//======================================================================//
+
+SlabAllocator::~SlabAllocator() {
+  auto release_all = [this](Header*& head) {
+    while (head) {
+      Header* const next = head->next;
+      this->releaseBlock(head);
+      head = next;
+    }
+  };
+  for (Bin& B : __bins) {
+    release_all(B.partial);
+    release_all(B.full);
+  }
+}
+
+void* SlabAllocator::allocate(usize size) {
+  const usize cls = SlabAllocator::ClassOf(size);
+  if __expect_false(cls >= classCount)
+    return this->allocateLarge(size);
+  void* P = nullptr;
+  (void) this->allocateBatch(cls, &P, 1);
+  return P;
+}
+
+void SlabAllocator::deallocate(void* P) {
+  if __expect_false(P == nullptr)
+    return;
+  Header* const H = SlabAllocator::HeaderOf(P);
+  if (H->kind == Header::Large)
+    return this->releaseBlock(H);
+  this->deallocateBatch(H->size_class, &P, 1);
+}
+
+usize SlabAllocator::allocateBatch(
+ usize size_class, void** out, usize n) {
+  __hc_invariant(size_class < classCount);
+  Bin& B = __bins[size_class];
+  sys::ScopedLock L(B.mtx);
+  usize count = 0;
+  while (count < n) {
+    Header* H = B.partial;
+    if (H == nullptr) {
+      H = this->newSlab(size_class);
+      if __expect_false(H == nullptr)
+        break;
+      push_slab(B.partial, H);
+    }
+    while (count < n && H->used < H->capacity)
+      out[count++] = take_object(H);
+    if (H->used == H->capacity) {
+      unlink_slab(B.partial, H);
+      push_slab(B.full, H);
+    }
+  }
+  return count;
+}
+
+void SlabAllocator::deallocateBatch(
+ usize size_class, void* const* in, usize n) {
+  __hc_invariant(size_class < classCount);
+  Bin& B = __bins[size_class];
+  sys::ScopedLock L(B.mtx);
+  for (usize Ix = 0; Ix < n; ++Ix) {
+    Header* const H = SlabAllocator::HeaderOf(in[Ix]);
+    __hc_invariant(H->size_class == size_class);
+    if (H->used == H->capacity) {
+      unlink_slab(B.full, H);
+      push_slab(B.partial, H);
+    }
+    give_object(H, in[Ix]);
+    // Keep a single empty slab around, release the rest.
+    if (H->used == 0 && (H->prev || H->next)) {
+      unlink_slab(B.partial, H);
+      this->releaseBlock(H);
+    }
+  }
+}
+
+SlabHeader* SlabAllocator::newSlab(usize size_class) {
+  const AddrRange block = __pages.allocate(slabSize);
+  void* const P = block.data();
+  if __expect_false(P == nullptr)
+    return nullptr;
+  if __expect_false((uptr(P) & (slabSize - 1)) || block.size() < slabSize) {
+    // Can't find the header from the object address.
+    __pages.release(block);
+    return nullptr;
+  }
+
+  Header* const H = common::construct_at(static_cast<Header*>(P));
+  const usize object_size = SlabAllocator::SizeOfClass(size_class);
+  const usize first = (sizeof(Header) + (object_size - 1))
+    & ~(object_size - 1);
+  H->kind = Header::Slab;
+  H->size_class = u8(size_class);
+  H->object_size = u32(object_size);
+  H->first = u32(first);
+  H->capacity = u32((slabSize - first) / object_size);
+  H->block_size = block.size();
+  return H;
+}
+
+void* SlabAllocator::allocateLarge(usize size) {
+  if __expect_false(size > Max<usize> - largeOffset)
+    return nullptr;
+  const AddrRange block = __pages.allocate(size + largeOffset);
+  void* const P = block.data();
+  if __expect_false(P == nullptr)
+    return nullptr;
+  if __expect_false(uptr(P) & (slabSize - 1)) {
+    __pages.release(block);
+    return nullptr;
+  }
+
+  Header* const H = common::construct_at(static_cast<Header*>(P));
+  H->kind = Header::Large;
+  H->block_size = block.size();
+  return static_cast<u8*>(P) + largeOffset;
+}
+
+void SlabAllocator::releaseBlock(SlabHeader* H) {
+  H->magic = 0;
+  __pages.release(AddrRange::New(H, H->block_size));
+}
+
+//======================================================================//
+// SlabCache
+//======================================================================//
+
+void* SlabCache::allocate(usize size) {
+  __hc_invariant(__heap != nullptr);
+  const usize cls = SlabAllocator::ClassOf(size);
+  if __expect_false(cls >= classCount)
+    return __heap->allocate(size);
+  Bin& B = __bins[cls];
+  if __expect_false(B.count == 0) {
+    B.count = __heap->allocateBatch(cls, B.items, batchSize);
+    if __expect_false(B.count == 0)
+      return nullptr;
+  }
+  return B.items[--B.count];
+}
+
+void SlabCache::deallocate(void* P) {
+  if __expect_false(P == nullptr)
+    return;
+  __hc_invariant(__heap != nullptr);
+  SlabHeader* const H = SlabAllocator::HeaderOf(P);
+  if (H->kind == SlabHeader::Large)
+    return __heap->deallocate(P);
+  Bin& B = __bins[H->size_class];
+  if __expect_false(B.count == binSize) {
+    // Give back the top half, the rest stays warm.
+    B.count -= batchSize;
+    __heap->deallocateBatch(H->size_class, B.items + B.count, batchSize);
+  }
+  B.items[B.count++] = P;
+}
+
+void SlabCache::flush() {
+  if (!__heap)
+    return;
+  for (usize cls = 0; cls < classCount; ++cls) {
+    Bin& B = __bins[cls];
+    if (B.count != 0)
+      __heap->deallocateBatch(cls, B.items, B.count);
+    B.count = 0;
+  }
+}
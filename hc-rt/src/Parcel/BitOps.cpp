@@ -0,0 +1,188 @@
+//===- Parcel/BitOps.cpp --------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include <Parcel/_BitOps.hpp>
+#include <Common/Casting.hpp>
+#include <Common/InlineMemset.hpp>
+#include <Common/MemUtils.hpp>
+
+using namespace hc;
+using namespace hc::parcel;
+using WordType = BitOps::WordType;
+
+#if defined(__AVX512F__)
+using VecType = rt::Gmu512;
+#elif defined(__AVX__)
+using VecType = rt::Gmu256;
+#elif defined(__SSE2__)
+using VecType = rt::Gmu128;
+#else
+using VecType = u64;
+#endif
+
+static constexpr usize wordBits = __bitsizeof(WordType);
+static constexpr usize vecWords = sizeof(VecType) / sizeof(WordType);
+static constexpr auto allSet = ~WordType(0);
+
+static_assert(sizeof(WordType) == sizeof(u64));
+
+//======================================================================//
+// Helpers
+//======================================================================//
+
+static __always_inline VecType load_vec(const WordType* P) {
+  return rt::load<VecType>(ptr_cast<const u8>(P));
+}
+
+static __always_inline void store_vec(WordType* P, VecType V) {
+  rt::store<VecType>(ptr_cast<u8>(P), V);
+}
+
+// Templated so the unused branch is discarded.
+template <typename VT>
+static __always_inline bool any_set(VT V) {
+  if constexpr (rt::__is_vector<VT>) {
+#if __has_builtin(__builtin_reduce_or)
+    return __builtin_reduce_or(V) != 0;
+#else
+    WordType R = 0;
+    for (usize I = 0; I < vecWords; ++I)
+      R |= V[I];
+    return R != 0;
+#endif
+  } else {
+    return V != 0;
+  }
+}
+
+template <typename VT>
+static __always_inline usize count_vec(VT V) {
+  if constexpr (rt::__is_vector<VT>) {
+#if __has_builtin(__builtin_elementwise_popcount) \
+ && __has_builtin(__builtin_reduce_add)
+    return usize(__builtin_reduce_add(
+      __builtin_elementwise_popcount(V)));
+#else
+    usize total = 0;
+    for (usize I = 0; I < vecWords; ++I)
+      total += __builtin_popcountll(V[I]);
+    return total;
+#endif
+  } else {
+    return __builtin_popcountll(V);
+  }
+}
+
+/// Applies `op` to the words, with the vector loop first.
+template <typename F>
+static __always_inline void bitwise(
+ WordType* dst, const WordType* src, usize len, F op) {
+  usize I = 0;
+  for (; I + vecWords <= len; I += vecWords)
+    store_vec(dst + I, op(load_vec(dst + I), load_vec(src + I)));
+  for (; I < len; ++I)
+    dst[I] = op(dst[I], src[I]);
+}
+
+//======================================================================//
+// Implementation
+//======================================================================//
+
+void BitOps::And(WordType* dst, const WordType* src, usize len) {
+  bitwise(dst, src, len, [](auto L, auto R) { return L & R; });
+}
+
+void BitOps::Or(WordType* dst, const WordType* src, usize len) {
+  bitwise(dst, src, len, [](auto L, auto R) { return L | R; });
+}
+
+void BitOps::Xor(WordType* dst, const WordType* src, usize len) {
+  bitwise(dst, src, len, [](auto L, auto R) { return L ^ R; });
+}
+
+void BitOps::AndNot(WordType* dst, const WordType* src, usize len) {
+  bitwise(dst, src, len, [](auto L, auto R) { return L & ~R; });
+}
+
+usize BitOps::Count(const WordType* src, usize len) {
+  usize total = 0;
+  usize I = 0;
+  for (; I + vecWords <= len; I += vecWords)
+    total += count_vec(load_vec(src + I));
+  for (; I < len; ++I)
+    total += __builtin_popcountll(src[I]);
+  return total;
+}
+
+isize BitOps::FindNext(const WordType* src, usize len, usize from) {
+  usize I = from / wordBits;
+  if __expect_false(I >= len)
+    return -1;
+  // Mask off the bits before `from` in the first word.
+  const WordType W = src[I] & (allSet << (from % wordBits));
+  if (W != 0)
+    return isize((I * wordBits) + __builtin_ctzll(W));
+
+  ++I;
+  // Skip empty blocks, the scalar loop finds the bit.
+  for (; I + vecWords <= len; I += vecWords) {
+    if (any_set(load_vec(src + I)))
+      break;
+  }
+  for (; I < len; ++I) {
+    if (src[I] != 0)
+      return isize((I * wordBits) + __builtin_ctzll(src[I]));
+  }
+  return -1;
+}
+
+void BitOps::SetRange(WordType* dst, usize begin, usize end) {
+  if __expect_false(begin >= end)
+    return;
+  const usize first = begin / wordBits;
+  const usize last  = end / wordBits;
+  const WordType head = allSet << (begin % wordBits);
+  const WordType tail = (WordType(1) << (end % wordBits)) - 1;
+  if (first == last) {
+    dst[first] |= (head & tail);
+    return;
+  }
+  dst[first] |= head;
+  common::inline_memset(dst + first + 1, 0xFF,
+    (last - first - 1) * sizeof(WordType));
+  if (tail != 0)
+    dst[last] |= tail;
+}
+
+void BitOps::ClearRange(WordType* dst, usize begin, usize end) {
+  if __expect_false(begin >= end)
+    return;
+  const usize first = begin / wordBits;
+  const usize last  = end / wordBits;
+  const WordType head = allSet << (begin % wordBits);
+  const WordType tail = (WordType(1) << (end % wordBits)) - 1;
+  if (first == last) {
+    dst[first] &= ~(head & tail);
+    return;
+  }
+  dst[first] &= ~head;
+  common::inline_bzero(dst + first + 1,
+    (last - first - 1) * sizeof(WordType));
+  if (tail != 0)
+    dst[last] &= ~tail;
+}
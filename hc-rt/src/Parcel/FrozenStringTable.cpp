@@ -0,0 +1,358 @@
+//===- Parcel/FrozenStringTable.cpp ---------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include <Parcel/FrozenStringTable.hpp>
+#include <Parcel/StringTable.hpp>
+#include <Common/Casting.hpp>
+#include <Common/InlineMemcpy.hpp>
+#include <Common/Limits.hpp>
+#include <Common/Strings.hpp>
+
+using namespace hc;
+using namespace hc::parcel;
+using HeaderType = FrozenStrTblHeader;
+
+static constexpr usize bucketLen
+  = usize(1) << FrozenStringTable::bucketShift;
+
+//======================================================================//
+// Encoding
+//======================================================================//
+
+/// Writes `V` as a ULEB128. Only counts the bytes if `P` is null.
+static usize write_uleb(u8* P, usize V) {
+  usize N = 0;
+  do {
+    u8 B = u8(V & 0x7F);
+    V >>= 7;
+    if (V != 0)
+      B |= 0x80;
+    if (P)
+      P[N] = B;
+    ++N;
+  } while (V != 0);
+  return N;
+}
+
+/// Reads a ULEB128, checking it doesn't go past `E`.
+static bool read_uleb(const u8*& P, const u8* E, usize& V) {
+  V = 0;
+  for (usize shift = 0; shift < 64; shift += 7) {
+    if __expect_false(P >= E)
+      return false;
+    const u8 B = *P++;
+    V |= usize(B & 0x7F) << shift;
+    if ((B & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+static u32 load_u32(const u8* P) {
+  u32 V = 0;
+  com::inline_memcpy(&V, P, sizeof(u32));
+  return V;
+}
+
+static void store_u32(u8* P, u32 V) {
+  com::inline_memcpy(P, &V, sizeof(u32));
+}
+
+static usize common_prefix(com::StrRef lhs, com::StrRef rhs) {
+  const usize len = (lhs.size() < rhs.size())
+    ? lhs.size() : rhs.size();
+  usize Ix = 0;
+  while (Ix < len && lhs[Ix] == rhs[Ix])
+    ++Ix;
+  return Ix;
+}
+
+/// Compares in shortlex order, like the table sorters.
+static int shortlex_compare(com::StrRef lhs, com::StrRef rhs) {
+  if (lhs.size() != rhs.size())
+    return (lhs.size() < rhs.size()) ? -1 : 1;
+  if (lhs.isEmpty())
+    return 0;
+  return com::__memcmp(lhs.data(), rhs.data(), lhs.size());
+}
+
+/// Writes a single entry. Only counts the bytes if `P` is null.
+static usize write_entry(
+ u8* P, com::StrRef prev, com::StrRef S, bool is_head) {
+  const usize shared = is_head ? 0 : common_prefix(prev, S);
+  const usize suffix = S.size() - shared;
+  usize N = 0;
+  if (!is_head)
+    N += write_uleb(P ? P + N : nullptr, shared);
+  N += write_uleb(P ? P + N : nullptr, suffix);
+  if (P)
+    com::inline_memcpy(P + N, S.data() + shared, suffix);
+  return N + suffix;
+}
+
+template <typename IntType>
+usize BasicIStringTable<IntType>::freeze(com::PtrRange<u8> out) const {
+  // Buckets are searched in shortlex order.
+  if __expect_false(!this->isSorted<true>())
+    return 0;
+
+  u32 count = 0;
+  usize max_len = 0;
+  // Encodes all the strings, only counting when `data` is null.
+  auto encode = [&, this](u8* data, u8* index) -> usize {
+    com::StrRef prev = com::StrRef::New("", usize(0));
+    usize off = 0;
+    count = 0;
+    for (const IdxType I : *tbl) {
+      // Empty strings are implicit.
+      if (I.length == 0)
+        continue;
+      const com::StrRef S = this->resolveDirect(I);
+      const bool is_head = (count & (bucketLen - 1)) == 0;
+      if (is_head && index) {
+        const usize bucket = count >> FrozenStringTable::bucketShift;
+        store_u32(index + (bucket * sizeof(u32)), u32(off));
+      }
+      off += write_entry(data ? data + off : nullptr, prev, S, is_head);
+      if (S.size() > max_len)
+        max_len = S.size();
+      prev = S;
+      ++count;
+    }
+    return off;
+  };
+
+  const usize data_size = encode(nullptr, nullptr);
+  const usize bucket_count = (count + (bucketLen - 1)) / bucketLen;
+  const usize index_offset = sizeof(HeaderType);
+  const usize data_offset  = index_offset + (bucket_count * sizeof(u32));
+  const usize total = data_offset + data_size;
+  if __expect_false(total > usize(Max<u32>))
+    return 0;
+  if (out.data() == nullptr)
+    return total;
+  if __expect_false(out.size() < total)
+    return 0;
+
+  HeaderType H {};
+  H.bucket_shift  = FrozenStringTable::bucketShift;
+  H.count         = count;
+  H.bucket_count  = u32(bucket_count);
+  H.index_offset  = u32(index_offset);
+  H.data_offset   = u32(data_offset);
+  H.data_size     = u32(data_size);
+  H.max_length    = u32(max_len);
+  if (this->doesNeedImplicitEmpty())
+    H.flags |= HeaderType::has_empty;
+
+  u8* const P = out.data();
+  com::inline_memcpy(P, &H, sizeof(HeaderType));
+  encode(P + data_offset, P + index_offset);
+  return total;
+}
+
+//======================================================================//
+// FrozenStringTable
+//======================================================================//
+
+FrozenStringTable FrozenStringTable::New(com::ImmAddrRange image) {
+  const usize size = image.size();
+  auto* const P = static_cast<const u8*>(image.data());
+  if __expect_false(!P || size < sizeof(HeaderType))
+    return {};
+
+  HeaderType H {};
+  com::inline_memcpy(&H, P, sizeof(HeaderType));
+  if (H.magic != HeaderType::kMagic || H.version != HeaderType::kVersion)
+    return {};
+  if (H.bucket_shift != bucketShift)
+    return {};
+  const usize bucket_count
+    = (usize(H.count) + (bucketLen - 1)) / bucketLen;
+  if (H.bucket_count != bucket_count)
+    return {};
+
+  // Check the sections are in bounds.
+  const usize index_end
+    = usize(H.index_offset) + (bucket_count * sizeof(u32));
+  const usize data_end
+    = usize(H.data_offset) + usize(H.data_size);
+  if (index_end > size || data_end > size)
+    return {};
+
+  FrozenStringTable T {};
+  T.image  = P;
+  T.index  = P + H.index_offset;
+  T.data   = P + H.data_offset;
+  T.header = H;
+  return T;
+}
+
+isize FrozenStringTable::indexOf(com::StrRef S) const {
+  if __expect_false(!this->isValid())
+    return -1;
+  S.dropNullMut();
+  if (S.isEmpty())
+    return this->hasEmpty() ? 0 : -1;
+  if (S.size() > header.max_length)
+    return -1;
+
+  const isize bucket = this->findBucket(S);
+  if (bucket < 0)
+    return -1;
+  const u8* P = this->bucketAt(bucket);
+  const u8* const E = this->bucketEnd(bucket);
+  if __expect_false(!P || !E)
+    return -1;
+
+  usize Ix = usize(bucket) << bucketShift;
+  const usize last = (Ix + bucketLen < header.count)
+    ? (Ix + bucketLen) : usize(header.count);
+  usize len = 0;
+  if (!read_uleb(P, E, len) || len > usize(E - P))
+    return -1;
+  const auto head = com::StrRef::New(
+    ptr_cast<const char>(P), len);
+  if (head.isEqual(S))
+    return isize(Ix) + this->hasEmpty();
+
+  // The length of the prefix shared by `S` and the current string.
+  usize match = common_prefix(head, S);
+  P += len;
+
+  for (++Ix; Ix < last; ++Ix) {
+    usize shared = 0, suffix = 0;
+    if (!read_uleb(P, E, shared) || !read_uleb(P, E, suffix))
+      return -1;
+    if (suffix > usize(E - P))
+      return -1;
+    len = shared + suffix;
+    // Shortlex, so everything after this is longer.
+    if (len > S.size())
+      return -1;
+    // If `shared > match`, the mismatch is still in the shared prefix.
+    if (shared < match)
+      match = shared;
+    if (shared == match) {
+      const usize rem = S.size() - match;
+      const usize N = (suffix < rem) ? suffix : rem;
+      usize J = 0;
+      while (J < N && P[J] == u8(S[match + J]))
+        ++J;
+      match += J;
+    }
+    P += suffix;
+    if (match == S.size() && len == S.size())
+      return isize(Ix) + this->hasEmpty();
+  }
+
+  return -1;
+}
+
+com::StrRef FrozenStringTable::resolveAt(
+ usize Ix, com::PtrRange<char> out) const {
+  if __expect_false(!this->isValid() || Ix >= this->size())
+    return invalidString;
+  char* const buf = out.data();
+  const usize cap = out.size();
+  if (this->hasEmpty()) {
+    if (Ix == 0) {
+      if (cap > 0)
+        buf[0] = '\0';
+      return com::StrRef::New("", usize(0));
+    }
+    --Ix;
+  }
+
+  const usize bucket = Ix >> bucketShift;
+  const u8* P = this->bucketAt(bucket);
+  const u8* const E = this->bucketEnd(bucket);
+  if __expect_false(!P || !E)
+    return invalidString;
+
+  usize len = 0;
+  if (!read_uleb(P, E, len) || len > usize(E - P) || len > cap)
+    return invalidString;
+  com::inline_memcpy(buf, P, len);
+  P += len;
+
+  // Rebuild each string in place until we reach `Ix`.
+  for (usize N = Ix & (bucketLen - 1); N > 0; --N) {
+    usize shared = 0, suffix = 0;
+    if (!read_uleb(P, E, shared) || !read_uleb(P, E, suffix))
+      return invalidString;
+    if (shared > len || suffix > usize(E - P) || shared + suffix > cap)
+      return invalidString;
+    com::inline_memcpy(buf + shared, P, suffix);
+    len = shared + suffix;
+    P += suffix;
+  }
+
+  if (len < cap)
+    buf[len] = '\0';
+  return com::StrRef::New(buf, len);
+}
+
+const u8* FrozenStringTable::bucketAt(usize Ix) const {
+  __hc_invariant(Ix < header.bucket_count);
+  const u32 off = load_u32(index + (Ix * sizeof(u32)));
+  if __expect_false(off >= header.data_size)
+    return nullptr;
+  return data + off;
+}
+
+const u8* FrozenStringTable::bucketEnd(usize Ix) const {
+  if (Ix + 1 < header.bucket_count)
+    return this->bucketAt(Ix + 1);
+  return data + header.data_size;
+}
+
+com::StrRef FrozenStringTable::headAt(usize Ix) const {
+  const u8* P = this->bucketAt(Ix);
+  const u8* const E = this->bucketEnd(Ix);
+  usize len = 0;
+  if (!P || !E || !read_uleb(P, E, len) || len > usize(E - P))
+    return invalidString;
+  return com::StrRef::New(ptr_cast<const char>(P), len);
+}
+
+isize FrozenStringTable::findBucket(com::StrRef S) const {
+  isize found = -1;
+  isize lhs = 0;
+  isize rhs = isize(header.bucket_count) - 1;
+
+  while (lhs <= rhs) {
+    const isize mid = (lhs + rhs) >> 1;
+    const com::StrRef head = this->headAt(usize(mid));
+    if __expect_false(head.data() == nullptr)
+      return -1;
+    if (shortlex_compare(head, S) <= 0) {
+      found = mid;
+      lhs = mid + 1;
+    } else {
+      rhs = mid - 1;
+    }
+  }
+
+  return found;
+}
+
+template usize hc::parcel::BasicIStringTable<u16>::freeze(
+  com::PtrRange<u8>) const;
+template usize hc::parcel::BasicIStringTable<u32>::freeze(
+  com::PtrRange<u8>) const;
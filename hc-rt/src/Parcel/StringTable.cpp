@@ -22,13 +22,21 @@
 //===----------------------------------------------------------------===//
 
 #include <Parcel/StringTable.hpp>
+#include <Common/Casting.hpp>
+#include <Common/DynAlloc.hpp>
 #include <Common/FastMath.hpp>
 #include <Common/InlineMemcpy.hpp>
+#include <Common/InlineMemmove.hpp>
+#include <Common/InlineMemset.hpp>
 #include <Common/Limits.hpp>
+#include <Common/Prefetching.hpp>
+#include <Common/Scratch.hpp>
 #include <Common/Strings.hpp>
 #include <Meta/Unwrap.hpp>
 
-#if _HC_FAST_STRING_TABLE
+#if _HC_RADIX_STRING_TABLE
+# include "_StrTblSortRadix.hpp"
+#elif _HC_FAST_STRING_TABLE
 # include "_StrTblSortFast.hpp"
 #else
 # include "_StrTblSortSlow.hpp"
@@ -36,9 +44,16 @@
 
 using namespace hc;
 using namespace hc::parcel;
-using Status = IStringTable::Status;
 
-IStringTable::Iterator& IStringTable::Iterator::operator++() {
+#if _HC_RADIX_STRING_TABLE
+template <typename IntType>
+using ShortlexSorter = ISTableRadixSorter<IntType>;
+#else
+template <typename IntType>
+using ShortlexSorter = ISTableSorter<IntType>;
+#endif
+template <typename IntType>
+auto BasicIStringTable<IntType>::Iterator::operator++() -> Iterator& {
   if __likely_false(!__iter_val) {
     *this = __base->ibegin();
     return *this;
@@ -47,36 +62,62 @@ IStringTable::Iterator& IStringTable::Iterator::operator++() {
   return *this;
 }
 
-IStringTable::Iterator::value_type
- IStringTable::Iterator::resolve() const {
+template <typename IntType>
+auto BasicIStringTable<IntType>::Iterator::resolve() const -> value_type {
   if __likely_false(!__iter_val)
-    return IStringTable::GetEmptyString();
+    return SelfType::GetEmptyString();
   return __base->resolveDirect(*__iter_val);
 }
 
 //======================================================================//
-// IStringTable
+// BasicIStringTable
 //======================================================================//
 
-static constexpr u16 emptyOffset = Max<u16>;
+template <typename IntType>
+static constexpr IntType emptyOffset = Max<IntType>;
 
-StrTblIdx IStringTable::GetEmptyIdx() {
-  return {emptyOffset, 0U};
+template <typename IntType>
+auto BasicIStringTable<IntType>::GetEmptyIdx() -> IdxType {
+  return {emptyOffset<IntType>, 0U};
 }
 
-bool IStringTable::IsEmptyIdx(const StrTblIdx I) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::IsEmptyIdx(const IdxType I) {
   const auto [off, len] = I;
-  return (off == emptyOffset) && (len == 0);
+  return (off == emptyOffset<IntType>) && (len == 0);
 }
 
-com::Pair<com::StrRef, Status> IStringTable::insert(com::StrRef S) {
+template <typename IntType>
+auto BasicIStringTable<IntType>::insert(com::StrRef S)
+ -> com::Pair<com::StrRef, Status> {
   S.dropNullMut();
   // Empty strings usually return.
   if (S.isEmpty())
     return this->emptyInsert();
 
+  if (this->isHashed()) {
+    // The index is always checked first, so duplicates are never added.
+    const com::StrRef curr = this->hashSearch(S);
+    if (!invalidString.isEqual(curr))
+      return {curr, Status::alreadyExists};
+    if __likely_false(!this->reserveFor(S))
+      return {invalidString, Status::atCapacity};
+    
+    com::Pair<com::StrRef, Status> R {};
+    if (!flags.ksorted) {
+      this->flags.is_sorted = false;
+      R = {this->appendDirect(S), Status::success};
+    } else {
+      R = this->binaryInsert(S);
+    }
+    // Offsets are stable, so sorting won't invalidate the index.
+    const auto off = R.t.data() - buf->data();
+    this->hashInsert({IntType(off), IntType(R.t.size())});
+    return R;
+  }
+
   // Handle cases where there is no capacity.
-  if __likely_false(!this->doesHaveStorageFor(S)) {
+  if __likely_false(!this->reserveFor(S)) {
     if (!this->isSorted<true>()) {
       // If we don't have immediate storage for the string, and we aren't
       // sorting the strings, immediately return.
@@ -99,23 +140,29 @@ com::Pair<com::StrRef, Status> IStringTable::insert(com::StrRef S) {
   return this->binaryInsert(S);
 }
 
-bool IStringTable::pop() {
+template <typename IntType>
+bool BasicIStringTable<IntType>::pop() {
   if (this->isDestructivePop()) {
     const auto [off, len] = tbl->back();
     if __likely_false(IsEmptyIdx({off, len})) {
       /// Sorted, so all the elements are empty.
       tbl->popBack();
+      this->accelInvalidate();
       return true;
     }
     const auto slen = usize(off + len) + flags.null_term;
     /// Checks if last element was the last appended.
     if (slen == tbl->size()) {
+      this->hashErase({off, len});
       tbl->popBack();
+      this->accelInvalidate();
       return true;
     }
     if (!flags.destructive)
       return false;
+    this->hashErase({off, len});
     tbl->popBack();
+    this->accelInvalidate();
     flags.dirty = true;
     return true;
   } else if __expect_false(!this->isPoppable()) {
@@ -123,8 +170,10 @@ bool IStringTable::pop() {
   }
   // Normal conditions
   auto last = $unwrap(tbl->popBack());
+  this->accelInvalidate();
   if (this->IsEmptyIdx(last))
     return true;
+  this->hashErase(last);
   const usize len = last.length + flags.null_term;
   return buf->resizeUninit(buf->size() - len);
 }
@@ -133,7 +182,8 @@ bool IStringTable::pop() {
 // Settings
 //======================================================================//
 
-bool IStringTable::setNullTerminationPolicy(bool V) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::setNullTerminationPolicy(bool V) {
   if __expect_false(this->isBufferInUse()) {
     // TODO: Output a warning.
     return flags.null_term;
@@ -142,7 +192,8 @@ bool IStringTable::setNullTerminationPolicy(bool V) {
   return V;
 }
 
-bool IStringTable::setImplicitEmptyValuePolicy(bool V) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::setImplicitEmptyValuePolicy(bool V) {
   // TODO: Finish implementing. Not in the mood to
   // refactor all this again...
   return flags.imp_empty;
@@ -154,7 +205,8 @@ bool IStringTable::setImplicitEmptyValuePolicy(bool V) {
   return V;
 }
 
-bool IStringTable::setDestructivePopPolicy(bool V) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::setDestructivePopPolicy(bool V) {
   if __expect_false(this->isDirty()) {
     // TODO: Output a warning.
     return flags.destructive;
@@ -163,7 +215,8 @@ bool IStringTable::setDestructivePopPolicy(bool V) {
   return V;
 }
 
-bool IStringTable::setKSortPolicy(bool V) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::setKSortPolicy(bool V) {
   const bool curr_policy = flags.ksorted;
   if (curr_policy == V)
     return curr_policy;
@@ -179,18 +232,31 @@ bool IStringTable::setKSortPolicy(bool V) {
 // Mutators
 //======================================================================//
 
-void IStringTable::shortlexSort(bool keep_sorted) {
+template <typename IntType>
+void BasicIStringTable<IntType>::shortlexSort(bool keep_sorted) {
   // TODO: At some point add runtime dispatch for checking the dirty bit.
   // We should probably check if ksorted is true, as that should probably
   // enable the dirty bit no matter what... not sure though.
   this->flags.ksorted = keep_sorted;
-  ISTableSorter S(this->buf, this->tbl);
+  ShortlexSorter<IntType> S(this->buf, this->tbl);
   // this->flags.dirty = S.do_sort(tbl->intoRange());
   S.do_sort(tbl->intoRange());
   this->flags.is_sorted = true;
+  (void) this->rebuildSearchAccelerator();
+}
+
+template <typename IntType>
+void BasicIStringTable<IntType>::shortlexSort(
+ TableType& scratch, bool keep_sorted) {
+  this->flags.ksorted = keep_sorted;
+  ShortlexSorter<IntType> S(this->buf, this->tbl, &scratch);
+  S.do_sort(tbl->intoRange());
+  this->flags.is_sorted = true;
+  (void) this->rebuildSearchAccelerator();
 }
 
-void IStringTable::unsort() {
+template <typename IntType>
+void BasicIStringTable<IntType>::unsort() {
   this->flags.ksorted = false;
   /// Do nothing if never sorted.
   if (!this->isSorted<true>()) {
@@ -198,19 +264,8 @@ void IStringTable::unsort() {
     return;
   }
 
-#if _HC_FAST_STRING_TABLE
-  __hc_todo("unsort");
-#endif
-  const usize len = this->size();
-  StrTblIdx* A = tbl->data();
-  for (usize Ix = 0; Ix < len; ++Ix) {
-    const StrTblIdx tmp = A[Ix];
-    usize J = Ix;
-    for (; (J > 0) && (A[J - 1].offset > tmp.offset); --J) {
-      A[J] = A[J - 1];
-    }
-    A[J] = tmp;
-  }
+  ISTableSorter<IntType> S(this->buf, this->tbl);
+  S.do_unsort(tbl->intoRange());
   // Mark as clean.
   // this->flags.dirty = false;
   this->flags.is_sorted = false;
@@ -220,51 +275,196 @@ void IStringTable::unsort() {
 // Internals
 //======================================================================//
 
-com::StrRef IStringTable::resolveAt(usize Ix) const {
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::resolveAt(usize Ix) const {
   __hc_invariant(Ix < tbl->size());
-  const StrTblIdx I = (*tbl)[Ix];
+  const IdxType I = (*tbl)[Ix];
   return this->resolveDirect(I);
 }
 
-com::StrRef IStringTable::resolveDirect(StrTblIdx I) const {
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::resolveDirect(IdxType I) const {
   if (this->isInlineEmpty(I))
-    return IStringTable::GetEmptyString();
+    return SelfType::GetEmptyString();
   __hc_invariant(I.offset + I.length <= buf->size());
   auto* const P = buf->data() + usize(I.offset);
   return com::StrRef::New(P, I.length);
 }
 
-com::StrRef IStringTable::locateString(com::StrRef S) const {
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::locateString(com::StrRef S) const {
+  // The hash index doesn't care about ordering.
+  if (this->isHashed() && !S.isEmpty())
+    return this->hashSearch(S);
   if __expect_false(!this->isSorted<true>())
     return invalidString;
   // Handle empty strings.
   if (S.isEmpty()) {
     if (flags.has_empty)
-      return IStringTable::GetEmptyString();
+      return SelfType::GetEmptyString();
     return invalidString;
   }
+  if (this->isAccelerated())
+    return this->accelSearch(S);
   return this->binarySearch(S);
 }
 
-bool IStringTable::doesHaveStorageFor(com::StrRef S) const {
+/// Compares in shortlex order, the same as the sorters.
+static bool shortlex_less(com::StrRef lhs, com::StrRef rhs) {
+  if (lhs.size() != rhs.size())
+    return lhs.size() < rhs.size();
+  if (lhs.isEmpty())
+    return false;
+  return com::__memcmp(lhs.data(), rhs.data(), lhs.size()) < 0;
+}
+
+/// Heap sorts the query indices by their strings.
+static void sort_query_order(
+ u32* order, usize len, const com::StrRef* keys) {
+  auto sift_down = [&](usize root, usize end) {
+    const u32 top = order[root];
+    while (true) {
+      usize child = (2 * root) + 1;
+      if (child >= end)
+        break;
+      if (child + 1 < end
+       && shortlex_less(keys[order[child]], keys[order[child + 1]]))
+        ++child;
+      if (!shortlex_less(keys[top], keys[order[child]]))
+        break;
+      order[root] = order[child];
+      root = child;
+    }
+    order[root] = top;
+  };
+
+  for (usize Ix = len / 2; Ix-- > 0;)
+    sift_down(Ix, len);
+  for (usize N = len; N > 1; --N) {
+    const u32 tmp = order[0];
+    order[0] = order[N - 1];
+    order[N - 1] = tmp;
+    sift_down(0, N - 1);
+  }
+}
+
+template <typename IntType>
+usize BasicIStringTable<IntType>::locateMany(
+ com::ImmPtrRange<com::StrRef> keys,
+ com::PtrRange<com::StrRef> out, bool presorted) const {
+  const usize K = keys.size();
+  __hc_invariant(out.size() >= K);
+  if __expect_false(K == 0)
+    return 0;
+  const com::StrRef* const pkeys = keys.data();
+  com::StrRef* const pout = out.data();
+  usize found = 0;
+
+  // Nothing to walk, so just do the lookups directly.
+  if (this->isHashed() || !this->isSorted<true>()) {
+    for (usize Ix = 0; Ix < K; ++Ix) {
+      pout[Ix] = this->locateString(pkeys[Ix]);
+      found += (pout[Ix].data() != nullptr);
+    }
+    return found;
+  }
+
+  $scratch(order, K, u32);
+  for (usize Ix = 0; Ix < K; ++Ix)
+    order[Ix] = u32(Ix);
+  if (!presorted)
+    sort_query_order(order.data(), K, pkeys);
+
+  // Far enough ahead to hide the latency of the `buf` loads.
+  constexpr usize prefetch_dist = 8;
+  const IdxType* const ptbl = tbl->data();
+  const char* const pbuf = buf->data();
+  const usize N = tbl->size();
+  usize pos = 0;
+
+  for (usize Ix = 0; Ix < K; ++Ix) {
+    const u32 Q = order[Ix];
+    const com::StrRef S = pkeys[Q];
+    if (S.isEmpty()) {
+      pout[Q] = flags.has_empty
+        ? SelfType::GetEmptyString() : invalidString;
+      found += flags.has_empty;
+      continue;
+    }
+
+    // Skip everything less than `S`. Lengths are checked first,
+    // so shorter strings never touch `buf`.
+    const usize len = S.size();
+    while (pos < N) {
+      // Every probe, since the entries ahead may match a later key.
+      if (pos + prefetch_dist < N) {
+        const usize off = ptbl[pos + prefetch_dist].offset;
+        rt::smart_prefetch<rt::PrefetchMode::Read>(
+          ptr_cast<const u8>(pbuf + off));
+      }
+      const IdxType I = ptbl[pos];
+      if (usize(I.length) > len)
+        break;
+      if (usize(I.length) == len
+       && com::__memcmp(pbuf + I.offset, S.data(), len) >= 0)
+        break;
+      ++pos;
+    }
+
+    pout[Q] = invalidString;
+    if (pos < N && usize(ptbl[pos].length) == len) {
+      const com::StrRef tblS = this->resolveDirect(ptbl[pos]);
+      if (tblS.isEqual(S)) {
+        pout[Q] = tblS;
+        ++found;
+      }
+    }
+  }
+
+  return found;
+}
+
+template <typename IntType>
+bool BasicIStringTable<IntType>::doesHaveStorageFor(com::StrRef S) const {
   /// Always available.
   if (S.isEmpty())
     return true;
-  if (tbl->isFull())
+  if (tbl->__remainingCapacity() == 0)
     return false;
   const usize len = (S.size() + flags.null_term);
+  // The maximum offset is reserved for empty strings.
+  if __expect_false(buf->size() + len > usize(Max<IntType>))
+    return false;
   return (buf->__remainingCapacity() >= len);
 }
 
-com::StrRef IStringTable::appendDirect(com::StrRef S) {
+template <typename IntType>
+bool BasicIStringTable<IntType>::reserveFor(com::StrRef S) {
+  if __expect_true(this->doesHaveStorageFor(S))
+    return true;
+  if (!this->grow || S.isEmpty())
+    return false;
+  const usize len = (S.size() + flags.null_term);
+  if __expect_false(buf->size() + len > usize(Max<IntType>))
+    return false;
+  // Growable storage will spill here, before any pointers are taken.
+  if (!this->grow(*this, 1, len))
+    return false;
+  return this->doesHaveStorageFor(S);
+}
+
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::appendDirect(com::StrRef S) {
   __hc_assert(!tbl->isFull());
   const auto [off, len] = this->appendDirectIter(S);
   // Add the new table index.
   tbl->emplace(off, len);
+  this->accelInvalidate();
   return com::StrRef::New(buf->data() + off, usize(len));
 }
 
-StrTblIdx IStringTable::appendDirectIter(com::StrRef S) {
+template <typename IntType>
+auto BasicIStringTable<IntType>::appendDirectIter(com::StrRef S) -> IdxType {
   const usize len = S.size();
   // Resize with enough space for the null terminator if required.
   char* const ptr = buf->growUninit(len + flags.null_term);
@@ -273,10 +473,12 @@ StrTblIdx IStringTable::appendDirectIter(com::StrRef S) {
   if (flags.null_term)
     ptr[len] = '\0';
   // Add the new table index.
-  return {u16(ptr - buf->begin()), u16(len)};
+  return {IntType(ptr - buf->begin()), IntType(len)};
 }
 
-com::Pair<com::StrRef, Status> IStringTable::binaryInsert(com::StrRef S) {
+template <typename IntType>
+auto BasicIStringTable<IntType>::binaryInsert(com::StrRef S)
+ -> com::Pair<com::StrRef, Status> {
   // Empty strings are not allowed, table MUST be sorted.
   __hc_invariant(!S.isEmpty());
   __hc_invariant(this->isSorted<true>());
@@ -344,47 +546,26 @@ com::Pair<com::StrRef, Status> IStringTable::binaryInsert(com::StrRef S) {
 
   // Another one to make sure we can insert the string.
   __hc_invariant(this->doesHaveStorageFor(S));
-  // Begin slide copying.
-  constexpr usize slide_len = 8;
-  StrTblIdx sbuf[slide_len];
-  auto* first = tbl->data() + insert_pos;
   auto* last  = tbl->growUninit(); // Old ::end().
-
-  // Copies in blocks until too small for buffer.
-  auto run_slide = [&] -> bool {
-    // Under the current rules this should never fail, but ya never know...
-    __hc_invariant((last >= first));
-    if ((last - first) < slide_len)
-      return false;
-    auto* slide = last - slide_len;
-    // TODO: Implement memmove so I can remove this...
-    static constexpr usize cpy_len 
-      = slide_len * sizeof(StrTblIdx);
-    com::inline_memcpy(sbuf, slide, cpy_len);
-    com::inline_memcpy(slide + 1, sbuf, cpy_len);
-    last = slide - 1;
-    return true;
-  };
-
-  while (run_slide()) {}
-  // If dist(first, last) > 0.
-  if (const usize part_slide_len = (last - first)) {
-    const usize cpy_len =
-      part_slide_len * sizeof(StrTblIdx);
-    com::inline_memcpy(sbuf, first, cpy_len);
-    com::inline_memcpy(first + 1, sbuf, cpy_len);
-  }
+  auto* first = tbl->data() + insert_pos;
+  // Shift everything after the insert position up by one.
+  __hc_invariant(last >= first);
+  if (const usize count = (last - first))
+    com::inline_memmove(first + 1, first, count * sizeof(IdxType));
 
   const auto iter = this->appendDirectIter(S);
   // Add the new table index at the insert position.
-  ptbl[insert_pos] = iter;
+  tbl->data()[insert_pos] = iter;
+  this->accelInvalidate();
   const auto new_str = com::StrRef::New(
     buf->data() + iter.offset, usize(len));
   return {new_str, Status::success};
 }
 
-com::Pair<com::StrRef, Status> IStringTable::emptyInsert() {
-  const auto emptyS = IStringTable::GetEmptyString();
+template <typename IntType>
+auto BasicIStringTable<IntType>::emptyInsert()
+ -> com::Pair<com::StrRef, Status> {
+  const auto emptyS = SelfType::GetEmptyString();
   if (flags.imp_empty) {
     this->flags.has_empty = true;
     return {emptyS, Status::alreadyExists};
@@ -393,13 +574,14 @@ com::Pair<com::StrRef, Status> IStringTable::emptyInsert() {
   // This is flawed because sorting and unsorting destroys
   // the order of empty elements. For now, leave this unfinished.
   __hc_todo("emptyInsert", {});
-  const StrTblIdx Ix 
-    = IStringTable::GetEmptyIdx();
+  const IdxType Ix 
+    = SelfType::GetEmptyIdx();
   tbl->pushBack(Ix);
   return {emptyS, Status::success};
 }
 
-com::StrRef IStringTable::binarySearch(com::StrRef S) const {
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::binarySearch(com::StrRef S) const {
   // Empty strings are not allowed, table MUST be sorted.
   __hc_invariant(!S.isEmpty() && this->isSorted<true>());
   if __expect_false(tbl->isEmpty())
@@ -444,3 +626,203 @@ com::StrRef IStringTable::binarySearch(com::StrRef S) const {
 
   return invalidString;
 }
+
+//======================================================================//
+// Hash Index
+//======================================================================//
+
+/// Word-at-a-time multiplicative hash. Symbols are usually short,
+/// so this is cheaper than a bytewise FNV for most inputs.
+static u64 hash_string(com::StrRef S) {
+  constexpr u64 K = 0x9E3779B97F4A7C15ULL;
+  auto* P = ptr_cast<const u8>(S.data());
+  usize len = S.size();
+  u64 H = u64(len) * K;
+  for (; len >= 8; len -= 8, P += 8) {
+    H = (H ^ rt::load<u64>(P)) * K;
+    H ^= (H >> 29);
+  }
+  if (len != 0) {
+    u64 W = 0;
+    for (usize Ix = 0; Ix < len; ++Ix)
+      W |= u64(P[Ix]) << (Ix * 8);
+    H = (H ^ W) * K;
+  }
+  return H ^ (H >> 32);
+}
+
+template <typename IntType>
+auto BasicIStringTable<IntType>::hashProbe(com::StrRef S) const -> IdxType* {
+  __hc_invariant(this->isHashed() && !S.isEmpty());
+  const usize mask = hsh.size() - 1;
+  IdxType* const slots = hsh.data();
+  usize Ix = hash_string(S) & mask;
+  // The index is always larger than the table, so this terminates.
+  while (true) {
+    IdxType* const slot = slots + Ix;
+    if (slot->length == 0)
+      return slot;
+    if (slot->length == S.size()) {
+      if (this->resolveDirect(*slot).isEqual(S))
+        return slot;
+    }
+    Ix = (Ix + 1) & mask;
+  }
+}
+
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::hashSearch(com::StrRef S) const {
+  const IdxType* const slot = this->hashProbe(S);
+  if (slot->length == 0)
+    return invalidString;
+  return this->resolveDirect(*slot);
+}
+
+template <typename IntType>
+void BasicIStringTable<IntType>::hashInsert(IdxType I) {
+  if (!this->isHashed() || I.length == 0)
+    return;
+  IdxType* const slot 
+    = this->hashProbe(this->resolveDirect(I));
+  __hc_invariant(slot->length == 0);
+  *slot = I;
+}
+
+template <typename IntType>
+void BasicIStringTable<IntType>::hashErase(IdxType I) {
+  if (!this->isHashed() || I.length == 0)
+    return;
+  const usize mask = hsh.size() - 1;
+  IdxType* const slots = hsh.data();
+  IdxType* const slot 
+    = this->hashProbe(this->resolveDirect(I));
+  if __expect_false(slot->length == 0)
+    return;
+  
+  // Backshift deletion, so we never need tombstones.
+  usize hole = usize(slot - slots);
+  usize Ix = hole;
+  while (true) {
+    Ix = (Ix + 1) & mask;
+    const IdxType curr = slots[Ix];
+    if (curr.length == 0)
+      break;
+    const usize home = hash_string(
+      this->resolveDirect(curr)) & mask;
+    // Only move entries whose home isn't in (hole, Ix].
+    if (((Ix - home) & mask) >= ((Ix - hole) & mask)) {
+      slots[hole] = curr;
+      hole = Ix;
+    }
+  }
+  slots[hole] = IdxType{0, 0};
+}
+
+template <typename IntType>
+void BasicIStringTable<IntType>::hashClear() {
+  if (!this->isHashed())
+    return;
+  com::inline_bzero(hsh.data(), hsh.sizeInBytes());
+}
+
+//======================================================================//
+// Search Accelerator
+//======================================================================//
+
+/// Packs the first 8 bytes so integer order matches `memcmp`.
+static StrTblSearchKey make_search_key(com::StrRef S) {
+  const usize len = S.size();
+  const usize N = (len < 8) ? len : 8;
+  u64 prefix = 0;
+  for (usize Ix = 0; Ix < N; ++Ix)
+    prefix |= u64(u8(S[Ix])) << ((7 - Ix) * 8);
+  return {prefix, u32(len), 0};
+}
+
+__always_inline static bool
+ search_key_less(const StrTblSearchKey& lhs, const StrTblSearchKey& rhs) {
+  if (lhs.length != rhs.length)
+    return lhs.length < rhs.length;
+  return lhs.prefix < rhs.prefix;
+}
+
+template <typename IntType>
+bool BasicIStringTable<IntType>::rebuildSearchAccelerator() {
+  // Unsorted tables never use the layout, it's rebuilt once sorted.
+  this->flags.accel_stale = true;
+  if (accel.size() <= tbl->size() || !this->isSorted<true>())
+    return false;
+  this->accelRebuild();
+  this->flags.accel_stale = false;
+  return true;
+}
+
+template <typename IntType>
+void BasicIStringTable<IntType>::accelRebuild() {
+  __hc_invariant(accel.size() > tbl->size());
+  // Slot 0 is unused, the root is at 1.
+  const usize placed = this->accelBuild(0, 1);
+  __hc_assert(placed == tbl->size());
+}
+
+template <typename IntType>
+usize BasicIStringTable<IntType>::accelBuild(usize Ix, usize K) {
+  if (K > tbl->size())
+    return Ix;
+  Ix = this->accelBuild(Ix, 2 * K);
+  StrTblSearchKey& key = accel.data()[K];
+  key = make_search_key(this->resolveAt(Ix));
+  key.rank = u32(Ix);
+  return this->accelBuild(Ix + 1, (2 * K) + 1);
+}
+
+template <typename IntType>
+com::StrRef BasicIStringTable<IntType>::accelSearch(com::StrRef S) const {
+  __hc_invariant(!S.isEmpty() && this->isSorted<true>());
+  if __expect_false(tbl->isEmpty())
+    return invalidString;
+
+  // Four keys per cache line, so this fetches two levels ahead.
+  constexpr usize prefetch_stride
+    = rt::cacheLinesSize<> / sizeof(StrTblSearchKey);
+  const usize N = tbl->size();
+  const StrTblSearchKey* const T = accel.data();
+  const StrTblSearchKey key = make_search_key(S);
+
+  usize K = 1;
+  while (K <= N) {
+    rt::smart_prefetch<rt::PrefetchMode::Read>(
+      ptr_cast<const u8>(T + (K * prefetch_stride)));
+    K = (2 * K) + usize(search_key_less(T[K], key));
+  }
+  // Undo the right turns taken after the last left turn.
+  K >>= __builtin_ffsll(i64(~K));
+  if (K == 0)
+    return invalidString;
+  if (T[K].length != key.length || T[K].prefix != key.prefix)
+    return invalidString;
+  // The prefix is the whole string.
+  if (S.size() <= 8)
+    return this->resolveAt(T[K].rank);
+
+  // Only compare the strings when the prefixes tie. Everything from
+  // `rank` on is ordered after the prefix, so search to the end.
+  usize lhs = T[K].rank;
+  usize rhs = N;
+  while (lhs < rhs) {
+    const usize mid = (lhs + rhs) >> 1;
+    if (shortlex_less(this->resolveAt(mid), S))
+      lhs = mid + 1;
+    else
+      rhs = mid;
+  }
+
+  if (lhs == N)
+    return invalidString;
+  if (const auto tblS = this->resolveAt(lhs); tblS.isEqual(S))
+    return tblS;
+  return invalidString;
+}
+
+template struct hc::parcel::BasicIStringTable<u16>;
+template struct hc::parcel::BasicIStringTable<u32>;
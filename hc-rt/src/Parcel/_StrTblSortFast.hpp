@@ -17,34 +17,62 @@
 //===----------------------------------------------------------------===//
 
 #pragma once
-#error Incomplete implementation!
-// TODO: Finish this eventually ig...
 
 #include <Parcel/StringTable.hpp>
 #include <Common/FastMath.hpp>
+#include <Common/Strings.hpp>
 
 namespace hc::parcel {
 namespace {
+template <typename IntType>
 struct ISTableSorter {
-  using Arr  = com::PtrRange<StrTblIdx>;
-  using Iter = StrTblIdx*;
+  using TblType = BasicIStringTable<IntType>;
+  using IdxType = BasicStrTblIdx<IntType>;
+  using Arr  = com::PtrRange<IdxType>;
+  using Iter = IdxType*;
   enum { __maxDepthFactor = 2 };
 public:
   ISTableSorter(
-    IStringTable::BufferType* buf,
-    IStringTable::TableType*  tbl) :
-   buf(buf->into<com::StrRef>()),
+    typename TblType::BufferType* buf,
+    typename TblType::TableType*  tbl,
+    typename TblType::TableType*  = nullptr) :
+   buf(buf->template into<com::StrRef>()),
    max_depth(com::bit_log2(tbl->size()) * __maxDepthFactor) {}
 public:
-  bool do_sort(com::PtrRange<StrTblIdx> A) {
+  bool do_sort(Arr A) {
     this->introsort(A.begin(), A.end(), max_depth);
     return this->mutated;
   }
 
+  /// Sorts by offset, which is the same as insertion order.
+  bool do_unsort(Arr A) {
+    this->heap_sort<true>(A.begin(), A.end());
+    return this->mutated;
+  }
+
 protected:
   /// Based on the libcxx `__introsort`.
   void introsort(Iter I, Iter E, usize depth, bool left = true);
 
+  /// Moves elements `<` the pivot at `*I` to the left.
+  /// @return The final position of the pivot.
+  Iter partition_with_equals_on_right(Iter I, Iter E);
+
+  /// Moves elements `<=` the pivot at `*I` to the left.
+  /// @return The first element `>` than the pivot.
+  Iter partition_with_equals_on_left(Iter I, Iter E);
+
+  void insertion_sort(Iter I, Iter E);
+
+  /// Assumes `*(I - 1)` is less than or equal to every element.
+  void insertion_sort_ung(Iter I, Iter E);
+
+  template <bool ByOffset = false>
+  void sift_down(Iter A, usize len, usize root);
+
+  template <bool ByOffset = false>
+  void heap_sort(Iter I, Iter E);
+
   /// @return The number of swaps.
   unsigned branching_sort3(Iter X, Iter Y, Iter Z) {
     if (!this->__comp(*Y, *X)) {
@@ -95,32 +123,32 @@ protected:
     __psort_swap(W, X, Y);
   }
 
-private:
+protected:
   static void __swap(Iter lhs, Iter rhs) {
-    const StrTblIdx tmp = *rhs;
+    const IdxType tmp = *rhs;
     *rhs = *lhs;
     *lhs = tmp;
   }
 
   /// Does ``*lhs < *rhs``.
-  bool __comp(StrTblIdx lhs, StrTblIdx rhs) {
-    const usize len = lhs.length;
-    if (len < rhs.length)
-      return true;
-    if (rhs.length > len)
-      return false;
-    
-    // Now for the real lex comp...
-    const char* const data = buf.data();
-    const char* plhs = data + lhs.offset;
-    const char* prhs = data + rhs.offset;
-
-    for (usize Ix = 0; Ix < len; ++Ix) {
-      if (plhs[Ix] != prhs[Ix])
-        return (plhs[Ix] < prhs[Ix]);
+  template <bool ByOffset = false>
+  bool __comp(IdxType lhs, IdxType rhs) {
+    if constexpr (ByOffset) {
+      return lhs.offset < rhs.offset;
+    } else {
+      const usize len = lhs.length;
+      if (len != rhs.length)
+        return (len < rhs.length);
+      if (len == 0)
+        return false;
+      
+      // Now for the real lex comp...
+      const char* const data = buf.data();
+      const char* plhs = data + lhs.offset;
+      const char* prhs = data + rhs.offset;
+      // Strings can't contain nulls, so this matches `__strncmp`.
+      return com::__memcmp(plhs, prhs, len) < 0;
     }
-
-    return false;
   }
 
   /// Does ``*lhs < *rhs``.
@@ -128,33 +156,37 @@ private:
     return ISTableSorter::__comp(*lhs, *rhs);
   }
 
+  /// Swaps when ``*Y < *X``.
   void __comp_swap(Iter X, Iter Y) {
-    const bool R = ISTableSorter::__comp(*X, *Y);
-    const StrTblIdx tmp = R ? *X : *Y;
-    *Y = R ? *Y : *X;
+    const bool R = ISTableSorter::__comp(*Y, *X);
+    const IdxType tmp = R ? *Y : *X;
+    *Y = R ? *X : *Y;
     *X = tmp;
     this->mutated |= R;
   }
 
+  /// Assumes ``*Y <= *Z``.
   void __psort_swap(Iter X, Iter Y, Iter Z) {
     bool R         = ISTableSorter::__comp(*Z, *X);
-    const StrTblIdx tmp = R ? *Z : *X;
+    const IdxType tmp = R ? *Z : *X;
     *Z             = R ? *X : *Z;
     this->mutated |= R;
     R              = ISTableSorter::__comp(tmp, *Y);
     *X             = R ? *X : *Y;
     *Y             = R ? *Y : tmp;
-    this->mutated |= R;
+    this->mutated |= !R;
   }
 
-private:
+protected:
   com::StrRef buf;
   bool mutated = false;
   // Default arg
   usize max_depth = 0;
 };
 
-void ISTableSorter::introsort(Iter I, Iter E, usize depth, bool left) {
+template <typename IntType>
+void ISTableSorter<IntType>::introsort(
+ Iter I, Iter E, usize depth, bool left) {
   constexpr usize inssort_upper = 24;
   constexpr usize tuckey_lower  = 128;
 
@@ -166,36 +198,34 @@ void ISTableSorter::introsort(Iter I, Iter E, usize depth, bool left) {
      case 1:
       return;
      case 2:
-      if (this->__comp(--E, I)) {
-        ISTableSorter::__swap(I, E);
+      if (this->__comp(E - 1, I)) {
+        ISTableSorter::__swap(I, E - 1);
         this->mutated = true;
       }
       return;
      case 3:
-      this->sort3(I, I + 1, --E);
+      this->sort3(I, I + 1, E - 1);
       return;
      case 4:
-      this->sort4(I, I + 1, I + 2, --E);
+      this->sort4(I, I + 1, I + 2, E - 1);
       return;
      case 5:
-      this->sort5(I, I + 1, I + 2, I + 3, --E);
+      this->sort5(I, I + 1, I + 2, I + 3, E - 1);
       return;
     }
 
     // Use insertion sort when under threshold.
     if (len < inssort_upper) {
-      __hc_todo("introsort::insertion_sort");
-      if (left) {
-        // this->insertion_sort(I, E);
-      } else {
-        // this->insertion_sort_ung(I, E);
-      }
+      if (left)
+        this->insertion_sort(I, E);
+      else
+        this->insertion_sort_ung(I, E);
       return;
     }
 
     if (depth == 0) {
-      __hc_todo("introsort::heap_sort");
-      // this->heap_sort(I, E);
+      // Too many bad pivots, fall back to guaranteed n*log(n).
+      this->heap_sort(I, E);
       return;
     }
     --depth;
@@ -215,12 +245,152 @@ void ISTableSorter::introsort(Iter I, Iter E, usize depth, bool left) {
       this->mutated |= !!swaps;
     }
 
-    if (!left && __comp(I - 1, I)) {
-
+    // If the previous element is equal to the pivot, all elements 
+    // `<=` the pivot are already in place. Only sort the rest.
+    if (!left && !this->__comp(I - 1, I)) {
+      I = this->partition_with_equals_on_left(I, E);
+      continue;
     }
 
-     __hc_todo("introsort");
+    Iter P = this->partition_with_equals_on_right(I, E);
+    // Recurse on the left, loop on the right.
+    this->introsort(I, P, depth, left);
+    I = P + 1;
+    left = false;
+  }
+}
+
+template <typename IntType>
+auto ISTableSorter<IntType>::partition_with_equals_on_right(Iter I, Iter E)
+ -> Iter {
+  const IdxType pivot = *I;
+  Iter first = I + 1;
+  Iter last  = E;
+
+  // Everything in [I + 1, first) is `< pivot`,
+  // and everything in [last, E) is `>= pivot`.
+  while (first < last && this->__comp(*first, pivot))
+    ++first;
+  while (first < last && !this->__comp(*(last - 1), pivot))
+    --last;
+  while (first < last) {
+    ISTableSorter::__swap(first++, --last);
+    this->mutated = true;
+    while (first < last && this->__comp(*first, pivot))
+      ++first;
+    while (first < last && !this->__comp(*(last - 1), pivot))
+      --last;
+  }
+
+  Iter P = first - 1;
+  if (P != I) {
+    *I = *P;
+    *P = pivot;
+    this->mutated = true;
+  }
+  return P;
+}
+
+template <typename IntType>
+auto ISTableSorter<IntType>::partition_with_equals_on_left(Iter I, Iter E)
+ -> Iter {
+  const IdxType pivot = *I;
+  Iter first = I + 1;
+  Iter last  = E;
+
+  // Everything in [I + 1, first) is `<= pivot`,
+  // and everything in [last, E) is `> pivot`.
+  while (first < last && !this->__comp(pivot, *first))
+    ++first;
+  while (first < last && this->__comp(pivot, *(last - 1)))
+    --last;
+  while (first < last) {
+    ISTableSorter::__swap(first++, --last);
+    this->mutated = true;
+    while (first < last && !this->__comp(pivot, *first))
+      ++first;
+    while (first < last && this->__comp(pivot, *(last - 1)))
+      --last;
+  }
+
+  Iter P = first - 1;
+  if (P != I) {
+    *I = *P;
+    *P = pivot;
+    this->mutated = true;
+  }
+  return first;
+}
+
+template <typename IntType>
+void ISTableSorter<IntType>::insertion_sort(Iter I, Iter E) {
+  if (I == E)
+    return;
+  for (Iter It = I + 1; It != E; ++It) {
+    if (!this->__comp(*It, *(It - 1)))
+      continue;
+    const IdxType tmp = *It;
+    Iter J = It;
+    do {
+      *J = *(J - 1);
+      --J;
+    } while (J != I && this->__comp(tmp, *(J - 1)));
+    *J = tmp;
+    this->mutated = true;
+  }
+}
+
+template <typename IntType>
+void ISTableSorter<IntType>::insertion_sort_ung(Iter I, Iter E) {
+  for (Iter It = I; It != E; ++It) {
+    if (!this->__comp(*It, *(It - 1)))
+      continue;
+    const IdxType tmp = *It;
+    Iter J = It;
+    // `*(I - 1)` acts as the sentinel.
+    do {
+      *J = *(J - 1);
+      --J;
+    } while (this->__comp(tmp, *(J - 1)));
+    *J = tmp;
+    this->mutated = true;
+  }
+}
+
+template <typename IntType>
+template <bool ByOffset>
+void ISTableSorter<IntType>::sift_down(Iter A, usize len, usize root) {
+  const IdxType top = A[root];
+  while (true) {
+    usize child = (2 * root) + 1;
+    if (child >= len)
+      break;
+    if (child + 1 < len && this->__comp<ByOffset>(A[child], A[child + 1]))
+      ++child;
+    if (!this->__comp<ByOffset>(top, A[child]))
+      break;
+    A[root] = A[child];
+    root = child;
+    this->mutated = true;
+  }
+  A[root] = top;
+}
+
+template <typename IntType>
+template <bool ByOffset>
+void ISTableSorter<IntType>::heap_sort(Iter I, Iter E) {
+  const usize len = (E - I);
+  if (len < 2)
+    return;
+  // Build the max heap.
+  for (usize Ix = len / 2; Ix-- > 0;)
+    this->sift_down<ByOffset>(I, len, Ix);
+  // Pop the max to the back.
+  for (usize N = len; N > 1; --N) {
+    ISTableSorter::__swap(I, I + (N - 1));
+    this->sift_down<ByOffset>(I, N - 1, 0);
   }
+  this->mutated = true;
 }
 } // namespace `anonymous`
 } // namespace hc::parcel
@@ -0,0 +1,189 @@
+//===- Parcel/_StrTblSortRadix.hpp ----------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  MSD radix sort for string tables. Shortlex keys are treated as the
+//  big-endian length followed by the string bytes, so the first passes
+//  group by length, and every string in a later bucket has the same
+//  length. Small buckets and deep recursion fall back to introsort.
+//  The histograms are taken from the scratch stack once per sort, so
+//  each level of recursion only uses a few words of stack.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include "_StrTblSortFast.hpp"
+#include <Common/InlineMemcpy.hpp>
+#include <Common/InlineMemset.hpp>
+#include <Common/Scratch.hpp>
+
+namespace hc::parcel {
+namespace {
+template <typename IntType>
+struct ISTableRadixSorter : ISTableSorter<IntType> {
+  using BaseType = ISTableSorter<IntType>;
+  using typename BaseType::TblType;
+  using typename BaseType::IdxType;
+  using typename BaseType::Arr;
+  using typename BaseType::Iter;
+  using ScratchType = typename TblType::TableType;
+  static constexpr usize __lenDigits = sizeof(IntType);
+  static constexpr usize __insSortUpper = 24;
+  static constexpr usize __maxLevel = 24;
+  /// One histogram per level, then the shared `next` and `ends`.
+  static constexpr usize __histSize = (__maxLevel + 2) * 256;
+public:
+  /// @param scratch Used for out-of-place passes when large enough.
+  /// Otherwise elements are permuted in place (American flag sort).
+  ISTableRadixSorter(
+    typename TblType::BufferType* buf,
+    typename TblType::TableType*  tbl,
+    ScratchType* scratch = nullptr) :
+   BaseType(buf, tbl), scratch(scratch) {}
+public:
+  bool do_sort(Arr A) {
+    $scratch(hist, __histSize, u32);
+    this->counts = hist.data();
+    this->next = counts + (__maxLevel * 256);
+    this->ends = next + 256;
+    this->radix_sort(A.begin(), A.end(), 0, 0);
+    if (scratch)
+      scratch->clear();
+    return this->mutated;
+  }
+
+protected:
+  void radix_sort(Iter I, Iter E, usize depth, usize level);
+
+  /// Stable distribution through `scratch`.
+  void distribute_copy(Iter I, Iter E, usize depth);
+  /// In-place cycle distribution.
+  void distribute_swap(Iter I, Iter E, usize depth);
+
+  /// Gets the byte at `depth` in the shortlex key.
+  __always_inline u8 digit(IdxType X, usize depth) const {
+    if (depth < __lenDigits) {
+      const usize shift = (__lenDigits - 1 - depth) * 8;
+      return u8(usize(X.length) >> shift);
+    }
+    const usize Ix = depth - __lenDigits;
+    __hc_invariant(Ix < X.length);
+    return u8(this->buf.data()[usize(X.offset) + Ix]);
+  }
+
+private:
+  ScratchType* scratch = nullptr;
+  /// The histograms, indexed by level.
+  u32* counts = nullptr;
+  /// The next free slot in each bucket, reused by every level.
+  u32* next = nullptr;
+  u32* ends = nullptr;
+};
+
+template <typename IntType>
+void ISTableRadixSorter<IntType>::radix_sort(
+ Iter I, Iter E, usize depth, usize level) {
+  while (true) {
+    const usize len = (E - I);
+    if (len < 2)
+      return;
+    if (len < __insSortUpper) {
+      this->insertion_sort(I, E);
+      return;
+    }
+    // Buckets past the length digits all have the same length,
+    // so running out of bytes means every element is equal.
+    if (depth >= __lenDigits + usize(I->length))
+      return;
+    if (level >= __maxLevel) {
+      // Long runs of splitting, just compare the rest.
+      this->introsort(I, E, this->max_depth);
+      return;
+    }
+
+    // Deeper levels use the next histogram, so this one stays intact.
+    u32* const C = this->counts + (level * 256);
+    com::inline_bzero(C, 256 * sizeof(u32));
+    for (Iter It = I; It != E; ++It)
+      ++C[this->digit(*It, depth)];
+    // Everything is in a single bucket, check the next byte.
+    if (C[this->digit(*I, depth)] == len) {
+      ++depth;
+      continue;
+    }
+
+    u32 pos = 0;
+    for (usize B = 0; B < 256; ++B) {
+      next[B] = pos;
+      pos += C[B];
+    }
+
+    if (scratch && scratch->capacity() >= len)
+      this->distribute_copy(I, E, depth);
+    else
+      this->distribute_swap(I, E, depth);
+    this->mutated = true;
+
+    // `next` is reused below, so walk the bucket sizes instead.
+    Iter first = I;
+    for (usize B = 0; B < 256; ++B) {
+      const u32 N = C[B];
+      if (N >= 2)
+        this->radix_sort(first, first + N, depth + 1, level + 1);
+      first += N;
+    }
+    return;
+  }
+}
+
+template <typename IntType>
+void ISTableRadixSorter<IntType>::distribute_copy(
+ Iter I, Iter E, usize depth) {
+  const usize len = (E - I);
+  scratch->clear();
+  scratch->resizeUninit(len);
+  IdxType* const out = scratch->data();
+  for (Iter It = I; It != E; ++It)
+    out[next[this->digit(*It, depth)]++] = *It;
+  com::inline_memcpy(I, out, len * sizeof(IdxType));
+}
+
+template <typename IntType>
+void ISTableRadixSorter<IntType>::distribute_swap(
+ Iter I, Iter E, usize depth) {
+  for (usize B = 0; B < 255; ++B)
+    ends[B] = next[B + 1];
+  ends[255] = u32(E - I);
+
+  for (usize B = 0; B < 256; ++B) {
+    while (next[B] < ends[B]) {
+      IdxType X = I[next[B]];
+      u8 D = this->digit(X, depth);
+      // Cycle until we find an element for this bucket.
+      while (D != B) {
+        const IdxType tmp = I[next[D]];
+        I[next[D]++] = X;
+        X = tmp;
+        D = this->digit(X, depth);
+      }
+      I[next[B]++] = X;
+    }
+  }
+}
+} // namespace `anonymous`
+} // namespace hc::parcel
@@ -23,36 +23,47 @@
 
 namespace hc::parcel {
 namespace {
+template <typename IntType>
 struct ISTableSorter {
-  using Arr  = com::PtrRange<StrTblIdx>;
-  using Iter = StrTblIdx*;
+  using TblType = BasicIStringTable<IntType>;
+  using IdxType = BasicStrTblIdx<IntType>;
+  using Arr  = com::PtrRange<IdxType>;
+  using Iter = IdxType*;
 public:
   ISTableSorter(
-    IStringTable::BufferType* buf,
-    IStringTable::TableType*) :
-   buf(buf->into<com::StrRef>()) {}
+    typename TblType::BufferType* buf,
+    typename TblType::TableType*,
+    typename TblType::TableType* = nullptr) :
+   buf(buf->template into<com::StrRef>()) {}
 public:
-  bool do_sort(com::PtrRange<StrTblIdx> A) {
+  bool do_sort(Arr A) {
     this->insertion_sort(A.begin(), A.end());
     return this->mutated;
   }
 
+  /// Sorts by offset, which is the same as insertion order.
+  bool do_unsort(Arr A) {
+    this->insertion_sort_offset(A.begin(), A.end());
+    return this->mutated;
+  }
+
 protected:
   void insertion_sort(Iter I, Iter E);
+  void insertion_sort_offset(Iter I, Iter E);
 
 private:
   static void __swap(Iter lhs, Iter rhs) {
-    const StrTblIdx tmp = *rhs;
+    const IdxType tmp = *rhs;
     *rhs = *lhs;
     *lhs = tmp;
   }
 
   /// Does ``*lhs < *rhs``.
-  bool __comp(StrTblIdx lhs, StrTblIdx rhs) {
+  bool __comp(IdxType lhs, IdxType rhs) {
     const usize len = lhs.length;
     if (len < rhs.length)
       return true;
-    if (rhs.length > len)
+    if (len > rhs.length)
       return false;
     if (len == 0)
       return false;
@@ -75,7 +86,8 @@ private:
   bool mutated = false;
 };
 
-void ISTableSorter::insertion_sort(Iter I, Iter E) {
+template <typename IntType>
+void ISTableSorter<IntType>::insertion_sort(Iter I, Iter E) {
   const usize len = (E - I);
   switch (len) {
    case 0:
@@ -97,5 +109,20 @@ void ISTableSorter::insertion_sort(Iter I, Iter E) {
     }
   }
 }
+
+template <typename IntType>
+void ISTableSorter<IntType>::insertion_sort_offset(Iter I, Iter E) {
+  const usize len = (E - I);
+  Iter A = I;
+  for (usize Ix = 0; Ix < len; ++Ix) {
+    const IdxType tmp = A[Ix];
+    usize J = Ix;
+    for (; (J > 0) && (A[J - 1].offset > tmp.offset); --J) {
+      A[J] = A[J - 1];
+      this->mutated = true;
+    }
+    A[J] = tmp;
+  }
+}
 } // namespace `anonymous`
 } // namespace hc::parcel
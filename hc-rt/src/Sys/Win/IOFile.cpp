@@ -19,6 +19,8 @@
 #include <Common/Casting.hpp>
 #include <Common/DynAlloc.hpp>
 #include <Common/InlineMemcpy.hpp>
+#include <Common/Scratch.hpp>
+#include <Parcel/AtomicSkiplist.hpp>
 #include <Parcel/Skiplist.hpp>
 #include <Sys/OpaqueError.hpp>
 #include <Sys/Win/IOFile.hpp>
@@ -34,7 +36,11 @@ using namespace hc::sys;
 
 namespace {
   constexpr usize max_files = RT_MAX_FILES;
+#if _HC_MULTITHREADED
+  constinit pcl::AtomicSkiplist<WinIOFile, max_files> file_slots {};
+#else
   constinit pcl::Skiplist<WinIOFile, max_files> file_slots {};
+#endif
 } // namespace `anonymous`
 
 //======================================================================//
@@ -52,7 +58,7 @@ WinIOFile* __nt_openfile(FileAdaptor& self, PtrRange<wchar_t> wpath, IIOMode fla
 
 WinIOFile* __nt_openfile(FileAdaptor& self, StrRef path, IIOMode flags) {
   __hc_invariant(!path.isEmpty());
-  auto wpath = $to_wstr(path.data());
+  $scratch_wstr(wpath, path.data());
   if (path.beginsWith("\\\\?\\"))
     // Assume the path was valid under Nt.
     wpath[1] = L'?';
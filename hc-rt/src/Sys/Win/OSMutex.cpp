@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------===//
 
 #include <Common/DynAlloc.hpp>
+#include <Common/Scratch.hpp>
 #include <Sys/OpaqueError.hpp>
 #include <Sys/OSMutex.hpp>
 #include "Mutant.hpp"
@@ -70,7 +71,7 @@ RawMtxHandle S::RawMtxHandle::New(const char* name) {
   if (!name)
     return RawMtxHandle::New(
       (const wchar_t*)nullptr);
-  auto wname = $to_wstr(name);
+  $scratch_wstr(wname, name);
   return RawMtxHandle::New(wname.data());
 }
 
@@ -42,7 +42,8 @@
 
 namespace hc {
 namespace parcel {
-  struct [[gsl::Pointer]] IStringTable;
+  template <typename> struct [[gsl::Pointer]] BasicIStringTable;
+  using IStringTable = BasicIStringTable<u16>;
 } // namespace parcel
 
 namespace sys {
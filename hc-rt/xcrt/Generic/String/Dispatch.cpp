@@ -0,0 +1,244 @@
+//===- String/Dispatch.cpp ------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  The baseline kernels are the ones used without dispatching. The
+//  wider sets reuse the same templates, but are flattened into
+//  functions compiled for the target, so every block uses its ISA.
+//
+//===----------------------------------------------------------------===//
+
+#include "Dispatch.hpp"
+#include "Utils.hpp"
+#include <Common/CpuFeatures.hpp>
+#include <Common/InlineMemcmp.hpp>
+#include <xcrt/String.hpp>
+
+HC_HAS_BUILTIN(reduce_or);
+
+using namespace hc;
+using namespace hc::rt;
+
+namespace {
+  template <typename VecType>
+  __always_inline void* __memcpy_impl(
+   void* __restrict dst, const void* __restrict src, usize len) {
+    auto* const D = static_cast<u8*>(dst);
+    auto* const S = static_cast<const u8*>(src);
+    if (len < 128)
+      __memcpy_dispatch(D, S, len);
+    else if __expect_false(__use_nontemporal(len))
+      __copy_nontemporal<VecType>(D, S, len);
+    else if (__use_rep_movsb(len))
+      __copy_rep_movsb(D, S, len);
+    else
+      __copy_aligned_blocks<sizeof(VecType)>(D, S, len);
+    return dst;
+  }
+
+  template <typename VecType>
+  __always_inline void* __memset_impl(void* dst, int ch, usize len) {
+    auto* D = static_cast<u8*>(dst);
+    const u8 val = u8(ch);
+    if (len <= 128) {
+      if (len != 0)
+        __memset_dispatch(D, val, len);
+      return dst;
+    }
+    if __expect_false(__use_nontemporal(len)) {
+      __set_nontemporal<VecType>(D, val, len);
+      return dst;
+    }
+    if (__use_rep_stosb(len)) {
+      __set_rep_stosb(D, val, len);
+      return dst;
+    }
+    __set_block<VecType>(D, val);
+    align_to_next_boundary<sizeof(VecType)>(D, len);
+    __set_loop_and_last<VecType>(D, val, len);
+    return dst;
+  }
+
+  template <typename VecType>
+  __always_inline bool __block_differs(const u8* lhs, const u8* rhs) {
+    const VecType V = load<VecType>(lhs) ^ load<VecType>(rhs);
+    return __builtin_reduce_or(V) != 0;
+  }
+
+  /// Scans for the first differing block, then orders it bytewise.
+  template <typename VecType>
+  __always_inline int __memcmp_impl(
+   const void* lhs, const void* rhs, usize len) {
+    static constexpr usize kSize = sizeof(VecType);
+    auto* const L = static_cast<const u8*>(lhs);
+    auto* const R = static_cast<const u8*>(rhs);
+    if (len <= kSize)
+      return common::inline_memcmp(L, R, len);
+    usize off = 0;
+    for (; off + kSize <= len; off += kSize) {
+      if (__block_differs<VecType>(L + off, R + off))
+        return __memcmp_dispatch(L + off, R + off, kSize);
+    }
+    if (off == len)
+      return 0;
+    // The overlapped bytes are already known to be equal.
+    off = len - kSize;
+    return __memcmp_dispatch(L + off, R + off, kSize);
+  }
+
+  template <typename VecType>
+  __always_inline usize __strlen_impl(const char* str) {
+    return xcrt::xstringlen_vec_read<VecType, char>(str);
+  }
+
+  template <typename VecType>
+  __always_inline void* __memchr_impl(const void* src, int ch, usize len) {
+    return xcrt::xFFC_vec_read<VecType, char>(
+      static_cast<const char*>(src), char(ch), len);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Kernels
+//======================================================================//
+
+namespace {
+  namespace baseline {
+    void* memcpy_k(
+     void* __restrict dst, const void* __restrict src, usize len) {
+      common::inline_memcpy(dst, src, len);
+      return dst;
+    }
+    void* memset_k(void* dst, int ch, usize len) {
+      common::inline_memset(dst, u8(ch), len);
+      return dst;
+    }
+    int memcmp_k(const void* lhs, const void* rhs, usize len) {
+      return common::inline_memcmp(lhs, rhs, len);
+    }
+    usize strlen_k(const char* str) {
+      return xcrt::stringlen(str);
+    }
+    void* memchr_k(const void* src, int ch, usize len) {
+      return xcrt::find_first_char(
+        static_cast<const char*>(src), char(ch), len);
+    }
+
+    constexpr xcrt::StringFns table {
+      &memcpy_k, &memset_k, &memcmp_k,
+      &strlen_k, &memchr_k,
+#if defined(__AVX512F__)
+      "avx512"
+#elif defined(__AVX2__)
+      "avx2"
+#elif defined(__SSE2__)
+      "sse2"
+#else
+      "generic"
+#endif
+    };
+  } // namespace baseline
+} // namespace `anonymous`
+
+#define _XCRT_KERNELS(tier, isa, vec) \
+namespace { namespace tier { \
+  [[gnu::target(isa), gnu::flatten]] \
+  void* memcpy_k(void* __restrict dst, const void* __restrict src, usize len) \
+   { return __memcpy_impl<vec>(dst, src, len); } \
+  [[gnu::target(isa), gnu::flatten]] \
+  void* memset_k(void* dst, int ch, usize len) \
+   { return __memset_impl<vec>(dst, ch, len); } \
+  [[gnu::target(isa), gnu::flatten]] \
+  int memcmp_k(const void* lhs, const void* rhs, usize len) \
+   { return __memcmp_impl<vec>(lhs, rhs, len); } \
+  [[gnu::target(isa), gnu::flatten]] \
+  usize strlen_k(const char* str) \
+   { return __strlen_impl<vec>(str); } \
+  [[gnu::target(isa), gnu::flatten]] \
+  void* memchr_k(const void* src, int ch, usize len) \
+   { return __memchr_impl<vec>(src, ch, len); } \
+  constexpr xcrt::StringFns table { \
+    &memcpy_k, &memset_k, &memcmp_k, \
+    &strlen_k, &memchr_k, #tier \
+  }; \
+}}
+
+#if _HC_RUNTIME_DISPATCH
+_XCRT_KERNELS(avx2,   "avx2", Gv256)
+_XCRT_KERNELS(avx512, "avx512f,avx512bw", Gv512)
+#endif
+
+#undef _XCRT_KERNELS
+
+//======================================================================//
+// Resolver
+//======================================================================//
+
+namespace {
+  void* resolve_memcpy(
+   void* __restrict dst, const void* __restrict src, usize len) {
+    __xcrt_string_setup();
+    $tail_return xcrt::__string_fns->memcpy(dst, src, len);
+  }
+  void* resolve_memset(void* dst, int ch, usize len) {
+    __xcrt_string_setup();
+    $tail_return xcrt::__string_fns->memset(dst, ch, len);
+  }
+  int resolve_memcmp(const void* lhs, const void* rhs, usize len) {
+    __xcrt_string_setup();
+    $tail_return xcrt::__string_fns->memcmp(lhs, rhs, len);
+  }
+  usize resolve_strlen(const char* str) {
+    __xcrt_string_setup();
+    $tail_return xcrt::__string_fns->strlen(str);
+  }
+  void* resolve_memchr(const void* src, int ch, usize len) {
+    __xcrt_string_setup();
+    $tail_return xcrt::__string_fns->memchr(src, ch, len);
+  }
+} // namespace `anonymous`
+
+namespace {
+  constexpr xcrt::StringFns __resolver_table {
+    &resolve_memcpy, &resolve_memset, &resolve_memcmp,
+    &resolve_strlen, &resolve_memchr,
+    "unresolved"
+  };
+} // namespace `anonymous`
+
+constinit const xcrt::StringFns*
+ xcrt::__string_fns = &__resolver_table;
+
+const char* xcrt::string_variant() {
+  return __string_fns->name;
+}
+
+extern "C" void __xcrt_string_setup(void) {
+#if _HC_RUNTIME_DISPATCH
+  switch (cpu_tier()) {
+   case CpuTier::AVX512:
+    xcrt::__string_fns = &avx512::table;
+    return;
+   case CpuTier::AVX2:
+    xcrt::__string_fns = &avx2::table;
+    return;
+   default:
+    break;
+  }
+#endif
+  xcrt::__string_fns = &baseline::table;
+}
@@ -0,0 +1,50 @@
+//===- String/Dispatch.hpp ------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  The string function resolver. When `_HC_RUNTIME_DISPATCH` is set,
+//  the exported functions call through a table which is bound to the
+//  widest kernels the CPU supports, once per process.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Fundamental.hpp>
+
+namespace xcrt {
+  struct StringFns {
+    void*(*memcpy)(void* __restrict, const void* __restrict, usize);
+    void*(*memset)(void*, int, usize);
+    int(*memcmp)(const void*, const void*, usize);
+    usize(*strlen)(const char*);
+    void*(*memchr)(const void*, int, usize);
+  public:
+    /// The name of the bound kernel set.
+    const char* name;
+  };
+
+  /// Starts bound to resolver thunks, so calls made
+  /// before `__xcrt_string_setup` still work.
+  extern const StringFns* __string_fns;
+} // namespace xcrt
+
+extern "C" {
+  /// Binds `xcrt::__string_fns`. Called from `__xcrt_setup`,
+  /// before any other threads exist.
+  void __xcrt_string_setup(void);
+} // extern "C"
@@ -0,0 +1,35 @@
+//===- String/Memchr.cpp --------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Dispatch.hpp"
+#include "Utils.hpp"
+
+extern "C" {
+  void* memchr(const void* __src, int __ch, usize __len) {
+#if _HC_RUNTIME_DISPATCH
+    $tail_return xcrt::__string_fns->memchr(__src, __ch, __len);
+#else
+    return xcrt::find_first_char(
+      static_cast<const char*>(__src), char(__ch), __len);
+#endif
+  }
+
+  wchar_t* wmemchr(const wchar_t* __src, wchar_t __ch, usize __len) {
+    return xcrt::wfind_first_char(__src, __ch, __len);
+  }
+} // extern "C"
@@ -17,11 +17,16 @@
 //===----------------------------------------------------------------===//
 
 #include <Common/InlineMemcmp.hpp>
+#include "Dispatch.hpp"
 
 using namespace hc;
 
 extern "C" {
   int memcmp(const void* __lhs, const void* __rhs, usize __len) {
+#if _HC_RUNTIME_DISPATCH
+    $tail_return xcrt::__string_fns->memcmp(__lhs, __rhs, __len);
+#else
     $tail_return common::inline_memcmp(__lhs, __rhs, __len);
+#endif
   }
 } // extern "C"
@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------===//
 
 #include <Common/InlineMemcpy.hpp>
+#include "Dispatch.hpp"
 
 using namespace hc;
 
@@ -24,8 +25,12 @@ extern "C" {
   void* memcpy(
    void* __restrict __dst, 
    const void* __restrict __src, usize __len) {
+#if _HC_RUNTIME_DISPATCH
+    $tail_return xcrt::__string_fns->memcpy(__dst, __src, __len);
+#else
     common::inline_memcpy(__dst, __src, __len);
     return __dst;
+#endif
   }
 
   wchar_t* wmemcpy(
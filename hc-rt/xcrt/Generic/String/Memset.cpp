@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------===//
 
 #include <Common/InlineMemset.hpp>
+#include "Dispatch.hpp"
 
 using namespace hc;
 
@@ -25,7 +26,11 @@ extern "C" {
    void* __restrict __dst,
    int __ch, usize __len
   ) {
+#if _HC_RUNTIME_DISPATCH
+    $tail_return xcrt::__string_fns->memset(__dst, __ch, __len);
+#else
     common::inline_memset(__dst, u8(__ch), __len);
     return __dst;
+#endif
   }
 } // extern "C"
@@ -31,6 +31,7 @@
 // #include <Common/Memory.hpp>
 #include <Parcel/BitSet.hpp>
 #include <Std/__algorithm/max.hpp>
+#include "VecScan.hpp"
 
 namespace xcrt {
 // For if other platforms are ever supported...
@@ -101,6 +102,10 @@ template <typename Char>
 inline usize xstringlen(const Char* src) {
   static_assert(sizeof(Char) <= 2);
   if constexpr (do_unsafe_multibyte_ops) {
+    if constexpr (has_vec_scan) {
+      if __expect_true(__is_lane_aligned(src))
+        return xstringlen_vec_read<__scan_vec, Char>(src);
+    }
     using ReadType = hc::intn_t<4 * sizeof(Char)>;
     return xstringlen_wide_read<ReadType, Char>(src);
   } else {
@@ -156,6 +161,10 @@ template <typename Char>
 inline usize xstringnlen(const Char* src, usize n) {
   static_assert(sizeof(Char) <= 2);
   if constexpr (do_unsafe_multibyte_ops) {
+    if constexpr (has_vec_scan) {
+      if __expect_true(__is_lane_aligned(src))
+        return xstringnlen_vec_read<__scan_vec, Char>(src, n);
+    }
     using ReadType = hc::intn_t<4 * sizeof(Char)>;
     return xstringnlen_wide_read<ReadType, Char>(src, n);
   } else {
@@ -171,7 +180,7 @@ __always_inline usize wstringnlen(const wchar_t* src, usize n) {
 }
 
 //======================================================================//
-// [w]strchr:
+// [w]memchr:
 //======================================================================//
 
 template <typename Int, typename Char>
@@ -214,6 +223,10 @@ inline void* xfind_first_char(
  const Char* S, Char C, usize max_read) {
   static_assert(sizeof(Char) <= 2);
   if constexpr (do_unsafe_multibyte_ops) {
+    if constexpr (has_vec_scan) {
+      if __expect_true(__is_lane_aligned(S))
+        return xFFC_vec_read<__scan_vec, Char>(S, C, max_read);
+    }
     using ReadType = hc::intn_t<4 * sizeof(Char)>;
     // Check if the overhead of aligning and generating a mask
     // is greater than the overlead of just doing a direct search.
@@ -235,6 +248,64 @@ inline wchar_t* wfind_first_char(
   return static_cast<wchar_t*>(P);
 }
 
+//======================================================================//
+// [w]strchr:
+//======================================================================//
+
+template <typename Int, typename Char>
+inline void* xstrchr_wide_read(const Char* src, Char C) {
+  constexpr usize alignTo = sizeof(Int);
+  const Char* S = src;
+  // Align the pointer to Int.
+  for (; uptr(S) % alignTo != 0; ++S) {
+    if (*S == C || *S == Char(L'\0'))
+      return (*S == C) ? hc::ptr_castex<>(S) : nullptr;
+  }
+  // Read through blocks, stopping on either character.
+  const Int C_mask = repeat_byte<Int, Char>(C);
+  for (auto* SI = hc::ptr_cast<const Int>(S);
+   !has_zeros<Int, Char>(*SI) &&
+   !has_zeros<Int, Char>((*SI) ^ C_mask); ++SI) {
+    S = hc::ptr_cast<const Char>(SI + 1);
+  }
+  // Find the character in the block.
+  for (; *S != C && *S != Char(L'\0'); ++S);
+  return (*S == C) ? hc::ptr_castex<>(S) : nullptr;
+}
+
+template <typename Char>
+[[maybe_unused]] inline void*
+ xstrchr_byte_read(const Char* S, Char C) {
+  for (; *S != C; ++S) {
+    if (*S == Char(L'\0'))
+      return nullptr;
+  }
+  return hc::ptr_castex<>(S);
+}
+
+template <typename Char>
+inline void* xstrchr(const Char* S, Char C) {
+  static_assert(sizeof(Char) <= 2);
+  if constexpr (do_unsafe_multibyte_ops) {
+    if constexpr (has_vec_scan) {
+      if __expect_true(__is_lane_aligned(S))
+        return xstrchr_vec_read<__scan_vec, Char>(S, C);
+    }
+    using ReadType = hc::intn_t<4 * sizeof(Char)>;
+    return xstrchr_wide_read<ReadType, Char>(S, C);
+  } else {
+    return xstrchr_byte_read<Char>(S, C);
+  }
+}
+
+inline char* stringchr(const char* S, char C) {
+  return static_cast<char*>(xstrchr<char>(S, C));
+}
+
+inline wchar_t* wstringchr(const wchar_t* S, wchar_t C) {
+  return static_cast<wchar_t*>(xstrchr<wchar_t>(S, C));
+}
+
 //======================================================================//
 // [w]str[n]cmp:
 //======================================================================//
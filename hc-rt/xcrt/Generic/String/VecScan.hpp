@@ -0,0 +1,197 @@
+//===- String/VecScan.hpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Vector scans for the string functions. Blocks are compared with
+//  `pcmpeq[b|w]`, then reduced with `pmovmskb` to one bit per byte.
+//  Every load is aligned to the vector size, so reading past the end
+//  of a string never touches the next page.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <Common/Casting.hpp>
+#include <Common/Fundamental.hpp>
+#include <Common/SSEVec.hpp>
+
+HC_HAS_BUILTIN(convertvector);
+
+namespace xcrt {
+#if defined(__AVX2__)
+__global bool has_vec_scan = true;
+using __scan_vec = hc::rt::Gv256;
+#elif defined(__SSE2__)
+__global bool has_vec_scan = true;
+using __scan_vec = hc::rt::Gv128;
+#else
+__global bool has_vec_scan = false;
+using __scan_vec = hc::rt::Gv128;
+#endif
+
+template <typename VecType, typename Char>
+struct VecScan {
+  static constexpr usize kSize  = sizeof(VecType);
+  static constexpr usize kLanes = kSize / sizeof(Char);
+  using Lane = hc::uintty_t<Char>;
+  using LaneVec  = Lane __attribute__((__vector_size__(kSize)));
+  using ByteVec  = i8 __attribute__((__vector_size__(kSize)));
+  using ByteMask = bool __attribute__((ext_vector_type(kSize)));
+  /// One bit per byte, so each `Char` sets `sizeof(Char)` bits.
+  using Mask = hc::uintn_t<kSize / 8>;
+public:
+  __always_inline static LaneVec Splat(Char C) {
+    return LaneVec{} + Lane(C);
+  }
+
+  /// @return The start of the block containing `P`.
+  __always_inline static const Char* Block(const Char* P) {
+    return hc::ptr_cast<const Char>(uptr(P) & ~uptr(kSize - 1));
+  }
+
+  /// @return The bytes between the start of the block and `P`.
+  __always_inline static usize Offset(const Char* P) {
+    return uptr(P) & (kSize - 1);
+  }
+
+  __always_inline static LaneVec Load(const Char* P) {
+    LaneVec V;
+    __builtin_memcpy_inline(&V,
+      __builtin_assume_aligned(P, kSize), kSize);
+    return V;
+  }
+
+  __always_inline static Mask Match(LaneVec V, LaneVec C) {
+    const auto eq = __builtin_bit_cast(ByteVec, V == C);
+    return __builtin_bit_cast(Mask,
+      __builtin_convertvector(eq, ByteMask));
+  }
+
+  /// @return The index of the first matching `Char`.
+  __always_inline static usize Index(Mask M) {
+    return usize(__builtin_ctzll(u64(M))) / sizeof(Char);
+  }
+};
+
+/// The scans read whole lanes, so wide strings must be aligned.
+template <typename Char>
+__always_inline bool __is_lane_aligned(const Char* P) {
+  return (uptr(P) & (sizeof(Char) - 1)) == 0;
+}
+
+//======================================================================//
+// Kernels
+//======================================================================//
+
+template <typename VecType, typename Char>
+inline usize xstringlen_vec_read(const Char* src) {
+  using Scan = VecScan<VecType, Char>;
+  using Mask = typename Scan::Mask;
+  const auto zero = Scan::Splat(Char(0));
+  const Char* S = Scan::Block(src);
+  // Drop the bytes before `src`.
+  const Mask first = Mask(
+    Scan::Match(Scan::Load(S), zero) >> Scan::Offset(src));
+  if (first != 0)
+    return Scan::Index(first);
+  for (;;) {
+    S += Scan::kLanes;
+    if (const Mask M = Scan::Match(Scan::Load(S), zero))
+      return usize(S - src) + Scan::Index(M);
+  }
+}
+
+template <typename VecType, typename Char>
+inline usize xstringnlen_vec_read(const Char* src, usize n) {
+  using Scan = VecScan<VecType, Char>;
+  using Mask = typename Scan::Mask;
+  if __expect_false(n == 0)
+    return 0;
+  const auto zero = Scan::Splat(Char(0));
+  const Char* S = Scan::Block(src);
+  const usize off = Scan::Offset(src);
+  const Mask first = Mask(Scan::Match(Scan::Load(S), zero) >> off);
+  if (first != 0) {
+    const usize Ix = Scan::Index(first);
+    return (Ix < n) ? Ix : n;
+  }
+  // Only blocks starting before `src + n` are read.
+  for (usize seen = (Scan::kSize - off) / sizeof(Char);
+   seen < n; seen += Scan::kLanes) {
+    S += Scan::kLanes;
+    if (const Mask M = Scan::Match(Scan::Load(S), zero)) {
+      const usize Ix = seen + Scan::Index(M);
+      return (Ix < n) ? Ix : n;
+    }
+  }
+  return n;
+}
+
+template <typename VecType, typename Char>
+inline void* xFFC_vec_read(const Char* src, Char C, usize n) {
+  using Scan = VecScan<VecType, Char>;
+  using Mask = typename Scan::Mask;
+  if __expect_false(n == 0)
+    return nullptr;
+  const auto needle = Scan::Splat(C);
+  const Char* S = Scan::Block(src);
+  const usize off = Scan::Offset(src);
+  const Mask first = Mask(Scan::Match(Scan::Load(S), needle) >> off);
+  if (first != 0) {
+    const usize Ix = Scan::Index(first);
+    return (Ix < n) ? hc::ptr_castex<>(src + Ix) : nullptr;
+  }
+  for (usize seen = (Scan::kSize - off) / sizeof(Char);
+   seen < n; seen += Scan::kLanes) {
+    S += Scan::kLanes;
+    if (const Mask M = Scan::Match(Scan::Load(S), needle)) {
+      const usize Ix = seen + Scan::Index(M);
+      return (Ix < n) ? hc::ptr_castex<>(src + Ix) : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+/// Finds `C` or the null terminator, whichever comes first.
+template <typename VecType, typename Char>
+inline void* xstrchr_vec_read(const Char* src, Char C) {
+  using Scan = VecScan<VecType, Char>;
+  using Mask = typename Scan::Mask;
+  const auto needle = Scan::Splat(C);
+  const auto zero = Scan::Splat(Char(0));
+  auto match = [&](const Char* P) -> Mask {
+    const auto V = Scan::Load(P);
+    return Scan::Match(V, needle) | Scan::Match(V, zero);
+  };
+
+  const Char* S = Scan::Block(src);
+  const Char* found = nullptr;
+  if (const Mask first = Mask(match(S) >> Scan::Offset(src)))
+    found = src + Scan::Index(first);
+  else {
+    for (;;) {
+      S += Scan::kLanes;
+      if (const Mask M = match(S)) {
+        found = S + Scan::Index(M);
+        break;
+      }
+    }
+  }
+  return (*found == C) ? hc::ptr_castex<>(found) : nullptr;
+}
+
+} // namespace xcrt
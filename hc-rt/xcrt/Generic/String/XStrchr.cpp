@@ -0,0 +1,29 @@
+//===- String/XStrchr.cpp -------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+
+#include "Utils.hpp"
+
+extern "C" {
+  char* strchr(const char* __str, int __ch) {
+    return xcrt::stringchr(__str, char(__ch));
+  }
+
+  wchar_t* wcschr(const wchar_t* __str, wchar_t __ch) {
+    return xcrt::wstringchr(__str, __ch);
+  }
+} // extern "C"
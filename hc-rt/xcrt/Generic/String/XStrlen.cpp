@@ -16,11 +16,16 @@
 //
 //===----------------------------------------------------------------===//
 
+#include "Dispatch.hpp"
 #include "Utils.hpp"
 
 extern "C" {
   usize strlen(const char* __src) {
+#if _HC_RUNTIME_DISPATCH
+    $tail_return xcrt::__string_fns->strlen(__src);
+#else
     return xcrt::stringlen(__src);
+#endif
   }
 
   usize wcslen(const wchar_t* __src) {
@@ -18,6 +18,10 @@
 
 #include <Memory/Box.hpp>
 #include <Common/DefaultFuncPtr.hpp>
+#include <Common/ManualDrop.hpp>
+#include <Common/Memory.hpp>
+#include <Common/SlabAllocator.hpp>
+#include <Sys/Locks.hpp>
 #include <Bootstrap/_NtModule.hpp>
 #include <Bootstrap/Win64KernelDefs.hpp>
 #include <Meta/Unwrap.hpp>
@@ -31,11 +35,18 @@ using namespace hc::bootstrap;
 namespace {
 
 using LOGICAL = u32;
+using NTSTATUS = i32;
 using AllocType = void*(void* heap_ptr, u32 flags, u32 size);
 using FreeType = LOGICAL(void* heap_ptr, u32 flags, void* alloc);
+using VAllocType = NTSTATUS(void* process, void** base,
+  uptr zero_bits, usize* size, u32 type, u32 protect);
+using VFreeType = NTSTATUS(void* process, void** base,
+  usize* size, u32 type);
 
-__imut DefaultFuncPtr<AllocType> RtlAllocateHeap {};
-__imut DefaultFuncPtr<FreeType>  RtlFreeHeap {};
+__imut DefaultFuncPtr<AllocType>  RtlAllocateHeap {};
+__imut DefaultFuncPtr<FreeType>   RtlFreeHeap {};
+__imut DefaultFuncPtr<VAllocType> NtAllocateVirtualMemory {};
+__imut DefaultFuncPtr<VFreeType>  NtFreeVirtualMemory {};
 __imut Win64Handle processHeap = nullptr;
 
 template <typename F>
@@ -54,10 +65,128 @@ static bool load_heap() {
   return !!processHeap;
 }
 
+//======================================================================//
+// Pages
+//======================================================================//
+
+static void* const currentProcess = reinterpret_cast<void*>(iptr(-1));
+
+constexpr usize slabSize = SlabAllocator::slabSize;
+/// Address space reserved for slabs, only committed as it's used.
+constexpr usize slabRegionSize = usize(1) << 32;
+/// Released slabs keep their first page, which links them together.
+constexpr usize slabLinkSize = 0x1000;
+
+/// Every slab comes from one reservation, so frees can tell slab
+/// objects from heap blocks by their address.
+struct SlabRegion {
+  sys::AtomicMtx mtx {};
+  u8* base = nullptr;
+  /// Zero until reserved, so nothing is in the region.
+  usize size = 0;
+  usize used = 0;
+  /// Decommitted slabs, reused before the rest of the region.
+  void* free = nullptr;
+};
+
+constinit SlabRegion slabRegion {};
+
+static bool reserve_slab_region() {
+  if (slabRegion.base)
+    return true;
+  void* P = nullptr;
+  usize size = slabRegionSize;
+  const NTSTATUS S = NtAllocateVirtualMemory(currentProcess,
+    &P, 0, &size, /*MEM_RESERVE*/ 0x2000, /*PAGE_READWRITE*/ 0x04);
+  if __expect_false(S < 0 || P == nullptr)
+    return false;
+  // Reservations are aligned to the 64KiB granularity.
+  static_assert(slabSize == 0x10000);
+  slabRegion.base = static_cast<u8*>(P);
+  slabRegion.size = size;
+  return true;
+}
+
+__always_inline static bool is_slab_object(void* P) {
+  return (uptr(P) - uptr(slabRegion.base)) < slabRegion.size;
+}
+
+/// Commits a slab from the region. Larger blocks come from the heap.
+static AddrRange alloc_pages(usize min_size) {
+  if __expect_false(min_size > slabSize)
+    return AddrRange::New();
+  sys::ScopedLock L(slabRegion.mtx);
+  void* P = slabRegion.free;
+  const bool reused = (P != nullptr);
+  if (!reused) {
+    if __expect_false(slabRegion.used + slabSize > slabRegion.size)
+      return AddrRange::New();
+    P = slabRegion.base + slabRegion.used;
+  }
+
+  void* base = P;
+  usize size = slabSize;
+  const NTSTATUS S = NtAllocateVirtualMemory(currentProcess,
+    &base, 0, &size, /*MEM_COMMIT*/ 0x1000, /*PAGE_READWRITE*/ 0x04);
+  if __expect_false(S < 0)
+    return AddrRange::New();
+  // Committing again keeps the link page intact.
+  if (reused)
+    slabRegion.free = *static_cast<void**>(P);
+  else
+    slabRegion.used += slabSize;
+  return AddrRange::New(P, slabSize);
+}
+
+/// Decommits all but the link page, and queues the slab for reuse.
+static void release_pages(AddrRange pages) {
+  u8* const P = static_cast<u8*>(pages.data());
+  void* tail = P + slabLinkSize;
+  usize size = slabSize - slabLinkSize;
+  (void) NtFreeVirtualMemory(currentProcess,
+    &tail, &size, /*MEM_DECOMMIT*/ 0x4000);
+  sys::ScopedLock L(slabRegion.mtx);
+  *reinterpret_cast<void**>(P) = slabRegion.free;
+  slabRegion.free = P;
+}
+
+//======================================================================//
+// Heap
+//======================================================================//
+
+/// Never destroyed, boxes may still be freed during shutdown.
+constinit ManualDrop<SlabAllocator> boxHeap {
+  PageProvider{&alloc_pages, &release_pages}
+};
+
+#if !_HC_EMUTLS
+/// Flushed by `box_heap_flush` when the thread exits.
+thread_local constinit ManualDrop<SlabCache> boxCache {
+  boxHeap.unwrap()
+};
+
+__always_inline static SlabCache& box_cache() {
+  return boxCache.unwrap();
+}
+#else
+// Emulated TLS is set up after the console, which allocates boxes.
+__always_inline static SlabAllocator& box_cache() {
+  return boxHeap.unwrap();
+}
+#endif
+
 } // namespace `anonymous`
 
 void* XCRT_NAMESPACE::box_heap_alloc(
  usize size, XCRT_NAMESPACE::HeapAllocFlags flags) {
+  if __expect_true(size <= SlabAllocator::maxSmallSize) {
+    if (void* const P = box_cache().allocate(size)) {
+      if (flags & HA_ZeroMemory)
+        (void) Mem::VSet(P, 0, size);
+      return P;
+    }
+  }
+  // Large blocks, or the slab region is full.
   auto hflags = static_cast<u32>(flags);
 #if !_HC_MULTITHREADED
   hflags |= XCRT_NAMESPACE::HA_NoSerialize;
@@ -67,6 +196,10 @@ void* XCRT_NAMESPACE::box_heap_alloc(
 
 bool XCRT_NAMESPACE::box_heap_free(
  void* ptr, bool no_serialize) {
+  if __expect_true(is_slab_object(ptr)) {
+    box_cache().deallocate(ptr);
+    return true;
+  }
   const auto hflags
 #if _HC_MULTITHREADED
     = no_serialize ? HA_NoSerialize : HA_None;
@@ -76,13 +209,23 @@ bool XCRT_NAMESPACE::box_heap_free(
   return !!RtlFreeHeap(processHeap, hflags, ptr);
 }
 
+void XCRT_NAMESPACE::box_heap_flush() {
+#if !_HC_EMUTLS
+  box_cache().flush();
+#endif
+}
+
 bool XCRT_NAMESPACE::setup_heap_funcs() {
   static bool has_succeeded = false;
   if __expect_false(!has_succeeded) {
     bool succeeded = true;
     $load_symbol(RtlAllocateHeap);
     $load_symbol(RtlFreeHeap);
+    $load_symbol(NtAllocateVirtualMemory);
+    $load_symbol(NtFreeVirtualMemory);
     succeeded &= load_heap();
+    // Without the region, every box comes from the heap.
+    (void) reserve_slab_region();
     has_succeeded = succeeded;
   }
   return has_succeeded;
@@ -31,6 +31,9 @@ enum HeapAllocFlags : u32 {
   HA_ZeroMemory   = 0x8,
 };
 
+/// Allocates up to 4KiB from the slab heap, through the thread's
+/// cache. Larger blocks come from the process heap, which is the only
+/// place the flags other than `HA_ZeroMemory` apply.
 void* box_heap_alloc(usize size, HeapAllocFlags flags = HA_Exceptions);
 bool box_heap_free(void* ptr, bool no_serialize = false);
 
@@ -49,6 +52,23 @@ inline void box_delete(T* P) {
   box_heap_free(P);
 }
 
+/// Allocator for `parcel::SmallVec`, backed by the box heap.
+/// Returns `nullptr` on failure instead of raising.
+struct BoxAllocator {
+  /// The smallest size class is 16 bytes.
+  static constexpr usize maxAlign = 16;
+public:
+  void* allocate(usize size, usize align) {
+    if __expect_false(align > maxAlign)
+      return nullptr;
+    return box_heap_alloc(size, HA_None);
+  }
+
+  void deallocate(void* P, usize, usize) {
+    box_heap_free(P);
+  }
+};
+
 // TODO: In the future, use a standard rt alias.
 template <typename T> struct Box {
   constexpr Box() = default;
@@ -133,4 +153,8 @@ template <typename T> struct Box<T[]> {
 
 bool setup_heap_funcs();
 
+/// Returns the objects cached by the current thread to the heap.
+/// Called when a thread exits.
+void box_heap_flush();
+
 } // namespace XCRT_NAMESPACE
@@ -89,6 +89,9 @@ extern "C" {
 
 
 void __xcrt_setup(void) {
+  // Bind the string kernels before anything else runs.
+  __xcrt_string_setup();
+
   // Make sure syscalls are bootstrapped.
   force_syscall_reload();
   if (!are_syscalls_loaded()) {
@@ -43,6 +43,7 @@ extern void __xcrt_setup(void);
 extern void __xcrt_shutdown(void);
 
 extern u64  __xcrt_locks_setup(void);
+extern void __xcrt_string_setup(void);
 extern void __xcrt_sysio_setup(void);
 extern void __xcrt_emutils_setup(void);
 
@@ -21,8 +21,43 @@
 //===----------------------------------------------------------------===//
 
 #include "Initialization.hpp"
+#include <Memory/Box.hpp>
+
+namespace {
+  using TlsCallback = void(*)(void* module, u32 reason, void* reserved);
+
+  /// `IMAGE_TLS_DIRECTORY64`, with pointers so it's constant.
+  struct TlsDirectory {
+    const void* raw_start;
+    const void* raw_end;
+    u32* index;
+    const TlsCallback* callbacks;
+    u32 zero_fill;
+    u32 characteristics;
+  };
+
+  static_assert(sizeof(TlsDirectory) == 40);
+
+  /// Runs on every thread exit, while its TLS is still valid.
+  void tls_thread_exit(void*, u32 reason, void*) {
+    if (reason == /*DLL_THREAD_DETACH*/ 3)
+      XCRT_NAMESPACE::box_heap_flush();
+  }
+} // namespace `anonymous`
 
 extern "C" {
-// TODO: Actually initialize
 constinit u32 _tls_index = 0;
+
+// The linker sorts `.tls$*` and `.CRT$XL*` by suffix, so these bound
+// the TLS template and the null terminated callback list.
+__section(".tls") constinit char _tls_start = 0;
+__section(".tls$ZZZ") constinit char _tls_end = 0;
+__section(".CRT$XLA") constinit TlsCallback __xl_a = nullptr;
+__section(".CRT$XLB") constinit TlsCallback __xl_b = &tls_thread_exit;
+__section(".CRT$XLZ") constinit TlsCallback __xl_z = nullptr;
+
+/// Found by the linker, which points the PE's TLS directory here.
+__section(".rdata$T") extern constinit const TlsDirectory _tls_used {
+  &_tls_start, &_tls_end, &_tls_index, &__xl_a + 1, 0, 0
+};
 } // extern "C"
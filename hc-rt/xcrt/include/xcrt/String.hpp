@@ -24,8 +24,12 @@ extern "C" {
 #define __rst __restrict
 
 int memcmp(const void* lhs, const void* rhs, usize len);
+void* memchr(const void* src, int ch, usize len);
+wchar_t* wmemchr(const wchar_t* src, wchar_t ch, usize len);
 void* memcpy(void* __rst dst, const void* __rst src, usize len);
 wchar_t* wmemcpy(wchar_t* __rst dst, const wchar_t* __rst src, usize len);
+void* memmove(void* dst, const void* src, usize len);
+wchar_t* wmemmove(wchar_t* dst, const wchar_t* src, usize len);
 void* memset(void* dst, int ch, usize len);
 
 #undef __rst
@@ -52,6 +56,11 @@ usize wcsnlen(const wchar_t* lhs, usize len);
 
 extern "C++" {
 
+char* strchr(char* str, int ch) __asm__("strchr");
+const char* strchr(const char* str, int ch) __asm__("strchr");
+wchar_t* wcschr(wchar_t* str, wchar_t ch) __asm__("wcschr");
+const wchar_t* wcschr(const wchar_t* str, wchar_t ch) __asm__("wcschr");
+
 char* strstr(char* str, const char* substr) __asm__("strstr");
 const char* strstr(const char* str, const char* substr) __asm__("strstr");
 wchar_t* wcsstr(wchar_t* str, const wchar_t* substr) __asm__("wcsstr");
@@ -61,10 +70,13 @@ const wchar_t* wcsstr(const wchar_t* str, const wchar_t* substr) __asm__("wcsstr
 
 namespace xcrt {
 
+using ::memchr;
 using ::memcmp;
 using ::memcpy;
+using ::memmove;
 using ::memset;
 
+using ::strchr;
 using ::strcmp;
 using ::strcpy;
 using ::strlen;
@@ -72,12 +84,18 @@ using ::strncmp;
 using ::strnlen;
 using ::strstr;
 
+using ::wcschr;
 using ::wcscmp;
 using ::wcscpy;
 using ::wcslen;
 using ::wcsncmp;
 using ::wcsnlen;
 using ::wcsstr;
+using ::wmemchr;
 using ::wmemcpy;
+using ::wmemmove;
+
+/// The name of the string kernels bound at startup.
+const char* string_variant();
 
 } // namespace xcrt
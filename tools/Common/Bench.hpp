@@ -0,0 +1,100 @@
+//===- Bench.hpp ----------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Timing and allocation helpers shared by the host tools. Include this
+//  before any runtime headers, the runtime finalizes some host macros.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <Common/Fundamental.hpp>
+
+namespace bench {
+  struct Stats {
+    double median = 0.0;
+    double p99 = 0.0;
+  };
+
+  /// Serialized `rdtsc`, counts reference cycles.
+  __always_inline u64 now() {
+    __builtin_ia32_lfence();
+    const u64 T = __builtin_ia32_rdtsc();
+    __builtin_ia32_lfence();
+    return T;
+  }
+
+  inline int __cmp_doubles(const void* lhs, const void* rhs) {
+    const double L = *static_cast<const double*>(lhs);
+    const double R = *static_cast<const double*>(rhs);
+    return (L > R) - (L < R);
+  }
+
+  /// Sorts `samples` in place.
+  inline Stats summarize(double* samples, u32 count) {
+    if (count == 0)
+      return {};
+    std::qsort(samples, count, sizeof(double), &__cmp_doubles);
+    const u32 p99 = (count * 99) / 100;
+    return {samples[count / 2], samples[p99 < count ? p99 : count - 1]};
+  }
+
+  /// Runs `F` `reps` times, after one warm up run.
+  /// @return The cycles per run divided by `units`.
+  template <typename F>
+  Stats measure(F&& fn, u32 reps, double units, double* samples) {
+    fn();
+    for (u32 R = 0; R < reps; ++R) {
+      const u64 start = bench::now();
+      fn();
+      samples[R] = double(bench::now() - start) / units;
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  /// `aligned_alloc` isn't in the UCRT, so this over-allocates
+  /// and keeps the original pointer just below the block.
+  inline void* aligned_alloc(usize align, usize size) {
+    if (align < sizeof(void*))
+      align = sizeof(void*);
+    u8* const raw = static_cast<u8*>(
+      std::malloc(size + align + sizeof(void*)));
+    if (!raw)
+      return nullptr;
+    const uptr base = uptr(raw + sizeof(void*));
+    u8* const P = reinterpret_cast<u8*>((base + align - 1) & ~uptr(align - 1));
+    reinterpret_cast<void**>(P)[-1] = raw;
+    return P;
+  }
+
+  inline void aligned_free(void* P) {
+    if (P)
+      std::free(static_cast<void**>(P)[-1]);
+  }
+
+  /// Keeps results alive without a volatile store per call.
+  inline volatile usize __sink = 0;
+
+  __always_inline void consume(usize V) {
+    __sink = __sink + V;
+  }
+} // namespace bench
@@ -0,0 +1,108 @@
+//===- Histogram.hpp ------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Call size histograms, recorded from a workload. The file format is
+//  one `<size> <count>` pair per line, `#` starts a comment.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <Common/Fundamental.hpp>
+
+struct Histogram {
+  static constexpr usize maxBins = 4096;
+  struct Bin {
+    usize size;
+    u64 count;
+  };
+public:
+  /// Adds `count` calls of `size` bytes, merging repeated sizes.
+  bool add(usize size, u64 count) {
+    if (count == 0)
+      return true;
+    for (usize Ix = 0; Ix < len; ++Ix) {
+      if (bins[Ix].size == size) {
+        bins[Ix].count += count;
+        this->total += count;
+        return true;
+      }
+    }
+    if (len == maxBins)
+      return false;
+    bins[len++] = {size, count};
+    this->total += count;
+    return true;
+  }
+
+  bool load(const char* path) {
+    FILE* F = std::fopen(path, "r");
+    if (!F)
+      return false;
+    char line[256];
+    bool ok = true;
+    while (ok && std::fgets(line, sizeof(line), F)) {
+      unsigned long long size = 0, count = 0;
+      if (line[0] == '#' || line[0] == '\n')
+        continue;
+      if (std::sscanf(line, "%llu %llu", &size, &count) != 2)
+        continue;
+      ok = this->add(usize(size), u64(count));
+    }
+    std::fclose(F);
+    return ok && total != 0;
+  }
+
+  /// A small-copy heavy mix, used when nothing was recorded.
+  /// This is a placeholder, not a measurement.
+  bool loadDefault() {
+    constexpr Bin defaults[] {
+      {1, 40},    {2, 30},    {4, 60},    {8, 120},
+      {12, 40},   {16, 140},  {24, 90},   {32, 110},
+      {48, 60},   {64, 80},   {96, 30},   {128, 40},
+      {256, 30},  {512, 20},  {1024, 12}, {4096, 6},
+      {16384, 2}, {65536, 1},
+    };
+    for (const Bin& B : defaults)
+      this->add(B.size, B.count);
+    return true;
+  }
+
+  /// Fills `out` with sizes drawn from the histogram.
+  /// Deterministic, so runs can be compared.
+  void sample(usize* out, usize n, usize max) const {
+    u64 state = 0x9E3779B97F4A7C15ULL;
+    for (usize Ix = 0; Ix < n; ++Ix) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      u64 pick = state % total;
+      usize Bx = 0;
+      for (; Bx + 1 < len && pick >= bins[Bx].count; ++Bx)
+        pick -= bins[Bx].count;
+      const usize size = bins[Bx].size;
+      out[Ix] = (size > max) ? max : size;
+    }
+  }
+
+public:
+  Bin bins[maxBins] {};
+  usize len = 0;
+  u64 total = 0;
+};
@@ -0,0 +1,62 @@
+include_guard(GLOBAL)
+
+# Shared setup for the host tools, which link against the host libc
+# instead of the runtime. Since the runtime only targets Windows, each
+# tool also configures on its own:
+#  cmake -S tools/<Tool> -B <dir> -DCMAKE_CXX_COMPILER=clang++
+
+get_filename_component(HC_TOOLS_ROOT "${CMAKE_CURRENT_LIST_DIR}/../.." ABSOLUTE)
+set(HC_TOOLS_RT "${HC_TOOLS_ROOT}/hc-rt")
+set(HC_TOOLS_COMMON "${CMAKE_CURRENT_LIST_DIR}")
+
+if(NOT CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
+  message(FATAL_ERROR "The host tools require Clang.")
+endif()
+
+# `Predefs.hpp` expects `__config.inc`, which only the runtime generates.
+set(HC_TOOLS_GEN "${CMAKE_BINARY_DIR}/hc-tools/gen")
+if(NOT EXISTS "${HC_TOOLS_RT}/include/__config.inc")
+  set(HCRT_VERSION "0.0.0")
+  set(HCRT_VERSION_MAJOR 0)
+  set(HCRT_VERSION_MINOR 0)
+  set(HCRT_VERSION_PATCH 0)
+  set(HCRT_VERSION_POSTFIX "tools")
+  configure_file("${HC_TOOLS_RT}/include/__config.inc.in"
+    "${HC_TOOLS_GEN}/__config.inc"
+    @ONLY
+    NEWLINE_STYLE LF
+  )
+endif()
+
+find_package(Threads)
+
+# Adds a host executable built against the runtime's headers.
+#  hc_host_tool(<name> [sources...])
+function(hc_host_tool name)
+  add_executable(${name} ${ARGN})
+  set_target_properties(${name} PROPERTIES
+    CXX_STANDARD 23
+    CXX_STANDARD_REQUIRED ON
+  )
+  target_include_directories(${name} PRIVATE
+    ${HC_TOOLS_GEN}
+    ${HC_TOOLS_COMMON}
+    ${HC_TOOLS_RT}/include
+    ${HC_TOOLS_RT}/src
+    ${HC_TOOLS_RT}/xcrt/Generic
+  )
+  target_compile_definitions(${name} PRIVATE
+    __HC_INTERNAL__=1
+    _HC_SOFTWARE_PREFETCH=1
+    _HC_MULTITHREADED=1
+    RT_MAX_THREADS=8
+  )
+  # Match the runtime's default codegen. `wchar_t` is 2 bytes on
+  # Windows, which the wide string kernels assume.
+  target_compile_options(${name} PRIVATE
+    -O2 -march=native -fshort-wchar -Wno-trigraphs
+  )
+  if(TARGET Threads::Threads)
+    target_link_libraries(${name} PRIVATE Threads::Threads)
+  endif()
+endfunction()
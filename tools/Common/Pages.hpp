@@ -0,0 +1,60 @@
+//===- Pages.hpp ----------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  A `PageProvider` over `mmap`, so the slab allocator can run on Linux
+//  hosts. Include this instead of `Threads.hpp`, `sys/mman.h` also has
+//  to come before the runtime's headers.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/mman.h>
+#include <Threads.hpp>
+#include <Common/PageProvider.hpp>
+
+namespace bench {
+  /// Blocks are aligned to this, the slab size.
+  inline constexpr usize kPageAlign = usize(1) << 16;
+
+  /// Maps an extra `kPageAlign` bytes and unmaps the slack around the
+  /// aligned block, as `mmap` only aligns to pages.
+  inline hc::com::AddrRange __map_pages(usize min_size) {
+    const usize size = (min_size + (kPageAlign - 1)) & ~(kPageAlign - 1);
+    void* const raw = mmap(nullptr, size + kPageAlign,
+      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+      return hc::com::AddrRange::New();
+    const uptr base = uptr(raw);
+    const uptr aligned = (base + (kPageAlign - 1)) & ~uptr(kPageAlign - 1);
+    if (aligned != base)
+      munmap(raw, aligned - base);
+    const uptr tail = aligned + size;
+    if (const usize slack = (base + size + kPageAlign) - tail)
+      munmap(reinterpret_cast<void*>(tail), slack);
+    return hc::com::AddrRange::New(reinterpret_cast<void*>(aligned), size);
+  }
+
+  inline void __unmap_pages(hc::com::AddrRange pages) {
+    munmap(pages.data(), pages.size());
+  }
+
+  inline hc::com::PageProvider mmap_pages() {
+    return {&__map_pages, &__unmap_pages};
+  }
+} // namespace bench
@@ -0,0 +1,93 @@
+//===- Threads.hpp --------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Runs a function on a group of host threads, for the scaling tools.
+//  Uses pthreads, which MinGW hosts also provide. Include this instead
+//  of `Bench.hpp`, as `pthread.h` has to come first.
+//
+//===----------------------------------------------------------------===//
+
+#pragma once
+
+// Before the runtime's headers, which redefine some glibc macros.
+#include <pthread.h>
+#include <Bench.hpp>
+
+namespace bench {
+  inline constexpr u32 kMaxThreads = 64;
+
+  struct __ThreadGroup {
+    void* fn = nullptr;
+    void(*call)(void*, u32) = nullptr;
+    u32 ready = 0;
+    u32 go = 0;
+  };
+
+  struct __ThreadArg {
+    __ThreadGroup* group = nullptr;
+    u32 tid = 0;
+    u64 end = 0;
+  };
+
+  inline void* __thread_main(void* P) {
+    auto* const A = static_cast<__ThreadArg*>(P);
+    __ThreadGroup* const G = A->group;
+    __atomic_fetch_add(&G->ready, 1, __ATOMIC_ACQ_REL);
+    while (!__atomic_load_n(&G->go, __ATOMIC_ACQUIRE))
+      __builtin_ia32_pause();
+    G->call(G->fn, A->tid);
+    A->end = bench::now();
+    return nullptr;
+  }
+
+  /// Runs `fn(tid)` on `count` threads, released together once all of
+  /// them have started. The caller's thread only waits.
+  /// @return The cycles from the release until the last one finished,
+  /// or 0 if the threads couldn't be created.
+  template <typename F>
+  u64 run_threads(u32 count, F& fn) {
+    if (count == 0 || count > kMaxThreads)
+      return 0;
+    pthread_t threads[kMaxThreads];
+    __ThreadArg args[kMaxThreads];
+    __ThreadGroup G {};
+    G.fn = &fn;
+    G.call = [](void* P, u32 tid) { (*static_cast<F*>(P))(tid); };
+
+    u32 started = 0;
+    for (; started < count; ++started) {
+      args[started] = {&G, started, 0};
+      if (pthread_create(&threads[started], nullptr,
+          &__thread_main, &args[started]) != 0)
+        break;
+    }
+    while (__atomic_load_n(&G.ready, __ATOMIC_ACQUIRE) != started)
+      __builtin_ia32_pause();
+    // Release the ones that did start, so they can be joined.
+    const u64 start = bench::now();
+    __atomic_store_n(&G.go, 1, __ATOMIC_RELEASE);
+
+    u64 end = start;
+    for (u32 Ix = 0; Ix < started; ++Ix) {
+      pthread_join(threads[Ix], nullptr);
+      if (args[Ix].end > end)
+        end = args[Ix].end;
+    }
+    return (started == count) ? (end - start) : 0;
+  }
+} // namespace bench
@@ -0,0 +1,524 @@
+//===- DispatchGen.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Generates `__memcpy_dispatch` and `__memset_dispatch` from a recorded
+//  size histogram. Size classes are checked in order of how often they
+//  were hit. The large block strategy is picked by a small timer in
+//  this tool, which runs each candidate over the recorded large sizes.
+//  It is not `hc-kernel-bench`, and only compares those candidates.
+//
+//  Usage: hc-dispatch-gen --hist <file> --memcpy <out> --memset <out>
+//                         [--no-bench]
+//         hc-dispatch-gen --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <Bench.hpp>
+
+#include <Common/InlineMemcpy.hpp>
+#include <Common/InlineMemset.hpp>
+
+#include <Histogram.hpp>
+
+using namespace hc;
+
+namespace {
+  constexpr usize kLarge = Max<usize>;
+  constexpr usize kCalls = 2048;
+  constexpr u32 kReps = 21;
+  /// Larger recorded sizes are clamped while timing.
+  constexpr usize kMaxTimed = usize(64) << 20;
+
+  struct Bucket {
+    usize lo, hi;
+    /// The statement run for this size class.
+    const char* body;
+    u64 weight = 0;
+  public:
+    constexpr bool contains(usize len) const {
+      return len >= lo && len <= hi;
+    }
+  };
+
+  /// The size classes of the untuned dispatch, in the same order.
+  constexpr Bucket kMemcpyBuckets[] {
+    {0,   0,   "return;"},
+    {1,   4,   "$tail_return __memcpy_small(dst, src, len);"},
+    {5,   7,   "$tail_return __copy_overlap_block<4>(dst, src, len);"},
+    {8,   15,  "$tail_return __copy_overlap_block<8>(dst, src, len);"},
+    {16,  31,  "$tail_return __copy_overlap_block<16>(dst, src, len);"},
+    {32,  63,  "$tail_return __copy_overlap_block<32>(dst, src, len);"},
+    {64,  127, "$tail_return __copy_overlap_block<64>(dst, src, len);"},
+    {128, kLarge, "$tail_return __memcpy_large(dst, src, len);"},
+  };
+
+  constexpr Bucket kMemsetBuckets[] {
+    {0,   0,   "return;"},
+    {1,   4,   "$tail_return __memset_small(dst, val, len);"},
+    {5,   8,   "$tail_return __set_first_last_block<u32>(dst, val, len);"},
+    {9,   16,  "$tail_return __set_first_last_block<u64>(dst, val, len);"},
+    {17,  32,  "$tail_return __set_first_last_block<v128>(dst, val, len);"},
+    {33,  64,  "$tail_return __set_first_last_block<v256>(dst, val, len);"},
+    {65,  128, "$tail_return __set_first_last_block<v512>(dst, val, len);"},
+    {129, kLarge, "$tail_return __memset_large(dst, val, len);"},
+  };
+
+  constexpr usize kMemcpyCount = sizeof(kMemcpyBuckets) / sizeof(Bucket);
+  constexpr usize kMemsetCount = sizeof(kMemsetBuckets) / sizeof(Bucket);
+  /// Where each large class starts, the timer only samples from here.
+  constexpr usize kMemcpyLarge = kMemcpyBuckets[kMemcpyCount - 1].lo;
+  constexpr usize kMemsetLarge = kMemsetBuckets[kMemsetCount - 1].lo;
+
+  template <usize N>
+  void weigh(Bucket (&buckets)[N], const Histogram& H) {
+    for (usize Ix = 0; Ix < H.len; ++Ix) {
+      const auto& bin = H.bins[Ix];
+      for (Bucket& B : buckets) {
+        if (B.contains(bin.size)) {
+          B.weight += bin.count;
+          break;
+        }
+      }
+    }
+  }
+
+  /// Most frequent first. Stable, so unused classes keep their order.
+  template <usize N>
+  void order(Bucket (&buckets)[N]) {
+    for (usize Ix = 1; Ix < N; ++Ix) {
+      const Bucket B = buckets[Ix];
+      usize Jx = Ix;
+      for (; Jx > 0 && buckets[Jx - 1].weight < B.weight; --Jx)
+        buckets[Jx] = buckets[Jx - 1];
+      buckets[Jx] = B;
+    }
+  }
+
+  /// @return The buckets of `table`, weighed and ordered by `H`.
+  template <usize N>
+  void build(Bucket (&buckets)[N],
+   const Bucket (&table)[N], const Histogram& H) {
+    for (usize Ix = 0; Ix < N; ++Ix)
+      buckets[Ix] = table[Ix];
+    weigh(buckets, H);
+    order(buckets);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Timing
+//======================================================================//
+
+namespace {
+  using CopyFn = void(*)(u8*, const u8*, usize);
+  using SetFn  = void(*)(u8*, u8, usize);
+
+  template <usize BlockSize>
+  [[gnu::noinline]] void copy_blocks(u8* dst, const u8* src, usize len) {
+    rt::__copy_aligned_blocks<BlockSize>(dst, src, len);
+  }
+
+  template <typename BlockType>
+  [[gnu::noinline]] void set_loop(u8* dst, u8 val, usize len) {
+    rt::__set_block<BlockType>(dst, val);
+    rt::align_to_next_boundary<alignof(BlockType)>(dst, len);
+    rt::__set_loop_and_last<BlockType>(dst, val, len);
+  }
+
+  [[gnu::noinline]] void set_prefetching(u8* dst, u8 val, usize len) {
+    rt::__prefetching_memset(dst, val, len);
+  }
+
+  struct CopyStrategy {
+    const char* name;
+    usize block;
+    CopyFn fn;
+  };
+
+  struct SetStrategy {
+    const char* name;
+    /// What goes after `__memset_large` picks its path.
+    const char* body;
+    SetFn fn;
+  };
+
+  constexpr CopyStrategy kCopyStrategies[] {
+    {"aligned_blocks<16>", 16, &copy_blocks<16>},
+    {"aligned_blocks<32>", 32, &copy_blocks<32>},
+    {"aligned_blocks<64>", 64, &copy_blocks<64>},
+  };
+
+  constexpr SetStrategy kSetStrategies[] {
+    {"loop<v128>",
+      "    __set_block<v128>(dst, val);\n"
+      "    align_to_next_boundary<alignof(v128)>(dst, len);\n"
+      "    $tail_return __set_loop_and_last<v128>(dst, val, len);\n",
+      &set_loop<rt::v128>},
+    {"loop<v256>",
+      "    __set_block<v256>(dst, val);\n"
+      "    align_to_next_boundary<alignof(v256)>(dst, len);\n"
+      "    $tail_return __set_loop_and_last<v256>(dst, val, len);\n",
+      &set_loop<rt::v256>},
+    {"loop<v512>",
+      "    __set_block<v512>(dst, val);\n"
+      "    align_to_next_boundary<alignof(v512)>(dst, len);\n"
+      "    $tail_return __set_loop_and_last<v512>(dst, val, len);\n",
+      &set_loop<rt::v512>},
+    {"prefetching",
+      "    $tail_return __prefetching_memset(dst, val, len);\n",
+      &set_prefetching},
+  };
+
+  constexpr usize kCopyCount = sizeof(kCopyStrategies) / sizeof(CopyStrategy);
+  constexpr usize kSetCount  = sizeof(kSetStrategies) / sizeof(SetStrategy);
+
+  /// The strategies of the untuned dispatch, used when nothing is timed.
+  constexpr usize kDefaultCopy = 1;
+  constexpr usize kDefaultSet  = 1;
+  static_assert(kCopyStrategies[kDefaultCopy].block == 32);
+
+  /// @return The median cycles to run `F` over every size.
+  u64 time_median(auto&& F, const usize* lens) {
+    double samples[kReps];
+    const bench::Stats S = bench::measure([&] {
+      for (usize Ix = 0; Ix < kCalls; ++Ix)
+        F(lens[Ix]);
+    }, kReps, 1.0, samples);
+    return u64(S.median);
+  }
+
+  /// Keeps the bins in `[lo, hi]`.
+  bool sub_histogram(const Histogram& H, usize lo, usize hi, Histogram& out) {
+    for (usize Ix = 0; Ix < H.len; ++Ix) {
+      const auto& bin = H.bins[Ix];
+      if (bin.size >= lo && bin.size <= hi)
+        out.add(bin.size, bin.count);
+    }
+    return out.total != 0;
+  }
+
+  struct Timer {
+    u8* src = nullptr;
+    u8* dst = nullptr;
+    usize lens[kCalls] {};
+    /// Samples the large sizes of `H`.
+    /// @return `false` if there are none.
+    bool init(const Histogram& H, usize lo) {
+      static Histogram large {};
+      large.len = 0, large.total = 0;
+      if (!sub_histogram(H, lo, kLarge, large))
+        return false;
+      large.sample(lens, kCalls, kMaxTimed);
+      usize max = 0;
+      for (usize len : lens)
+        max = (len > max) ? len : max;
+      // Leave room for misaligning the buffers.
+      src = static_cast<u8*>(std::malloc(max + 64));
+      dst = static_cast<u8*>(std::malloc(max + 64));
+      if (!src || !dst)
+        return false;
+      std::memset(src, 0x5A, max + 64);
+      return true;
+    }
+
+    ~Timer() {
+      std::free(src);
+      std::free(dst);
+    }
+
+    usize pickCopy() {
+      usize best = kDefaultCopy;
+      u64 best_time = Max<u64>;
+      for (usize Ix = 0; Ix < kCopyCount; ++Ix) {
+        const CopyFn fn = kCopyStrategies[Ix].fn;
+        const u64 T = time_median([&, this](usize len) {
+          fn(dst + 1, src + 3, len);
+        }, lens);
+        std::fprintf(stderr, "memcpy %-20s %llu\n",
+          kCopyStrategies[Ix].name, (unsigned long long)T);
+        if (T < best_time)
+          best = Ix, best_time = T;
+      }
+      return best;
+    }
+
+    usize pickSet() {
+      usize best = kDefaultSet;
+      u64 best_time = Max<u64>;
+      for (usize Ix = 0; Ix < kSetCount; ++Ix) {
+        const SetFn fn = kSetStrategies[Ix].fn;
+        const u64 T = time_median([&, this](usize len) {
+          fn(dst + 1, u8(0x5A), len);
+        }, lens);
+        std::fprintf(stderr, "memset %-20s %llu\n",
+          kSetStrategies[Ix].name, (unsigned long long)T);
+        if (T < best_time)
+          best = Ix, best_time = T;
+      }
+      return best;
+    }
+  };
+} // namespace `anonymous`
+
+//======================================================================//
+// Emission
+//======================================================================//
+
+namespace {
+  void emit_header(FILE* F, const char* hist, bool timed) {
+    std::fprintf(F,
+      "//===- Generated by hc-dispatch-gen, do not edit. ---------------===//\n"
+      "//\n"
+      "//  Size classes are ordered by the histogram in:\n"
+      "//   %s\n"
+      "//\n", hist);
+    if (timed) {
+      std::fprintf(F,
+        "//  The large strategy was picked by hc-dispatch-gen's own timer,\n"
+        "//  which only compares its fixed candidates on the build host.\n"
+        "//  It was not measured with hc-kernel-bench.\n");
+    } else {
+      std::fprintf(F,
+        "//  The large strategy is the untuned default, nothing was timed.\n");
+    }
+    std::fprintf(F,
+      "//\n"
+      "//===----------------------------------------------------------------===//\n"
+      "\n");
+  }
+
+  void emit_range(FILE* F, const Bucket& B, u64 total) {
+    const double pct = total ? (100.0 * double(B.weight) / double(total)) : 0.0;
+    if (B.lo == B.hi)
+      std::fprintf(F, "    if (len == %zu) // %.2f%%\n", B.lo, pct);
+    else if (B.hi == kLarge)
+      std::fprintf(F, "    if (len >= %zu) // %.2f%%\n", B.lo, pct);
+    else
+      std::fprintf(F, "    if (len - %zu <= %zu) // [%zu, %zu]: %.2f%%\n",
+        B.lo, B.hi - B.lo, B.lo, B.hi, pct);
+  }
+
+  /// Checks each class in order, the last one is the fallthrough.
+  template <usize N>
+  void emit_branches(FILE* F, const Bucket (&buckets)[N], u64 total) {
+    for (usize Ix = 0; Ix + 1 < N; ++Ix) {
+      emit_range(F, buckets[Ix], total);
+      std::fprintf(F, "      %s\n", buckets[Ix].body);
+    }
+    std::fprintf(F, "    // else:\n    %s\n", buckets[N - 1].body);
+  }
+
+  bool emit_memcpy(const char* path, const char* hist,
+   const Histogram& H, const CopyStrategy& large, bool timed) {
+    Bucket buckets[kMemcpyCount];
+    build(buckets, kMemcpyBuckets, H);
+
+    FILE* F = std::fopen(path, "w");
+    if (!F)
+      return false;
+    emit_header(F, hist, timed);
+    std::fprintf(F,
+      "  _HC_MEMCPY_FN(__memcpy_large) {\n"
+      "    if __expect_false(__use_nontemporal(len))\n"
+      "      $tail_return __copy_nontemporal(dst, src, len);\n"
+      "    if (__use_rep_movsb(len))\n"
+      "      $tail_return __copy_rep_movsb(dst, src, len);\n"
+      "    // Fastest: %s\n"
+      "    $tail_return __copy_aligned_blocks<%zu>(dst, src, len);\n"
+      "  }\n\n"
+      "  [[gnu::always_inline]] _HC_MEMCPY_FN(__memcpy_dispatch) {\n",
+      large.name, large.block);
+    emit_branches(F, buckets, H.total);
+    std::fprintf(F, "  }\n");
+    return std::fclose(F) == 0;
+  }
+
+  bool emit_memset(const char* path, const char* hist,
+   const Histogram& H, const SetStrategy& large, bool timed) {
+    Bucket buckets[kMemsetCount];
+    build(buckets, kMemsetBuckets, H);
+
+    FILE* F = std::fopen(path, "w");
+    if (!F)
+      return false;
+    emit_header(F, hist, timed);
+    std::fprintf(F,
+      "  _HC_MEMSET_FN(__memset_large) {\n"
+      "    if __expect_false(__use_nontemporal(len))\n"
+      "      $tail_return __set_nontemporal(dst, val, len);\n"
+      "    if (__use_rep_stosb(len))\n"
+      "      $tail_return __set_rep_stosb(dst, val, len);\n"
+      "    // Fastest: %s\n"
+      "%s"
+      "  }\n\n"
+      "  [[gnu::always_inline]] static _HC_MEMSET_FN(__memset_dispatch) {\n",
+      large.name, large.body);
+    emit_branches(F, buckets, H.total);
+    std::fprintf(F, "  }\n");
+    return std::fclose(F) == 0;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Checking
+//======================================================================//
+
+namespace {
+  /// The class the emitted branches pick for `len`.
+  template <usize N>
+  const char* selected(const Bucket (&buckets)[N], usize len) {
+    for (usize Ix = 0; Ix + 1 < N; ++Ix) {
+      if (buckets[Ix].contains(len))
+        return buckets[Ix].body;
+    }
+    return buckets[N - 1].body;
+  }
+
+  /// The class the untuned `__memcpy_dispatch` picks for `len`.
+  usize default_memcpy(usize len) {
+    if (len == 0)  return 0;
+    if (len < 5)   return 1;
+    if (len < 8)   return 2;
+    if (len < 16)  return 3;
+    if (len < 32)  return 4;
+    if (len < 64)  return 5;
+    if (len < 128) return 6;
+    return 7;
+  }
+
+  /// The class the untuned `__memset_dispatch` picks for `len`.
+  usize default_memset(usize len) {
+    if (len == 0)   return 0;
+    if (len < 5)    return 1;
+    if (len <= 8)   return 2;
+    if (len <= 16)  return 3;
+    if (len <= 32)  return 4;
+    if (len <= 64)  return 5;
+    if (len <= 128) return 6;
+    return 7;
+  }
+
+  template <usize N>
+  u32 check_against(const char* name, const Bucket (&table)[N],
+   usize(*expected)(usize), const Histogram& H, const usize* lens, usize n) {
+    Bucket buckets[N];
+    build(buckets, table, H);
+    u32 failed = 0;
+    for (usize Ix = 0; Ix < n; ++Ix) {
+      const char* body = selected(buckets, lens[Ix]);
+      if (body != table[expected(lens[Ix])].body) {
+        std::fprintf(stderr, "%s: %zu picks '%s'.\n", name, lens[Ix], body);
+        ++failed;
+      }
+    }
+    return failed;
+  }
+
+  /// Generates from a uniform histogram, and checks every size
+  /// takes the same path as the untuned dispatch.
+  int check() {
+    constexpr usize kSmall = 1024;
+    static Histogram H {};
+    static usize lens[kSmall + 64];
+    usize n = 0;
+    for (usize len = 0; len < kSmall; ++len) {
+      H.add(len, 1);
+      lens[n++] = len;
+    }
+    for (usize len = kSmall; len != 0 && n < kSmall + 63; len <<= 1)
+      lens[n++] = len;
+    lens[n++] = kLarge;
+
+    u32 failed = 0;
+    failed += check_against("memcpy",
+      kMemcpyBuckets, &default_memcpy, H, lens, n);
+    failed += check_against("memset",
+      kMemsetBuckets, &default_memset, H, lens, n);
+    std::fprintf(stderr, "%u mismatches.\n", failed);
+    return failed ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  const char* hist = nullptr;
+  const char* memcpy_out = nullptr;
+  const char* memset_out = nullptr;
+  bool do_bench = true;
+  for (int Ix = 1; Ix < argc; ++Ix) {
+    const char* arg = argv[Ix];
+    if (std::strcmp(arg, "--check") == 0)
+      return check();
+    if (std::strcmp(arg, "--no-bench") == 0) {
+      do_bench = false;
+      continue;
+    }
+    if (Ix + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+      return 1;
+    }
+    const char* val = argv[++Ix];
+    if (std::strcmp(arg, "--hist") == 0)
+      hist = val;
+    else if (std::strcmp(arg, "--memcpy") == 0)
+      memcpy_out = val;
+    else if (std::strcmp(arg, "--memset") == 0)
+      memset_out = val;
+    else {
+      std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+      return 1;
+    }
+  }
+
+  if (!hist || !memcpy_out || !memset_out) {
+    std::fprintf(stderr, "Usage: hc-dispatch-gen --hist <file> "
+      "--memcpy <out> --memset <out> [--no-bench]\n"
+      "       hc-dispatch-gen --check\n");
+    return 1;
+  }
+
+  static Histogram H {};
+  if (!H.load(hist)) {
+    std::fprintf(stderr, "Unable to load histogram '%s'.\n", hist);
+    return 1;
+  }
+
+  usize copy_ix = kDefaultCopy;
+  usize set_ix  = kDefaultSet;
+  bool copy_timed = false;
+  bool set_timed  = false;
+  if (do_bench) {
+    // The large classes start at different sizes.
+    if (Timer T {}; T.init(H, kMemcpyLarge))
+      copy_ix = T.pickCopy(), copy_timed = true;
+    if (Timer T {}; T.init(H, kMemsetLarge))
+      set_ix = T.pickSet(), set_timed = true;
+  }
+
+  if (!emit_memcpy(memcpy_out, hist, H,
+   kCopyStrategies[copy_ix], copy_timed)) {
+    std::fprintf(stderr, "Unable to write '%s'.\n", memcpy_out);
+    return 1;
+  }
+  if (!emit_memset(memset_out, hist, H,
+   kSetStrategies[set_ix], set_timed)) {
+    std::fprintf(stderr, "Unable to write '%s'.\n", memset_out);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,1048 @@
+//===- KernelBench.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Host benchmark for the runtime's string kernels. Each kernel is run
+//  next to the host libc over fixed sizes, a log sweep, and a recorded
+//  size histogram, at several alignments. Results are written as CSV.
+//
+//  Timings use `rdtsc`, which counts reference cycles, so pin the
+//  process and disable frequency scaling for stable numbers.
+//
+//  With `--strategies`, it instead sweeps the large block strategies
+//  against each other, and prints where each one starts to win. Those
+//  crossovers are what the probe's thresholds are derived from. Each
+//  strategy's result is checked first, unaligned and at every length
+//  modulo a cache line.
+//
+//  With `--check`, it instead compares the vector string scans with
+//  libc, at every offset in a vector and against an unmapped page,
+//  the overlapping moves with a byte-wise copy, and the strategies.
+//
+//  Usage: hc-kernel-bench [--hist <file>] [--max <bytes>]
+//                         [--reps <n>] [--out <file>] [--strategies]
+//         hc-kernel-bench --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <sys/mman.h>
+#include <Bench.hpp>
+
+#include <Common/CpuFeatures.hpp>
+#include <Common/InlineMemcmp.hpp>
+#include <Common/InlineMemcpy.hpp>
+#include <Common/InlineMemmove.hpp>
+#include <Common/InlineMemset.hpp>
+#include <String/Utils.hpp>
+
+#include <Histogram.hpp>
+
+using namespace hc;
+
+namespace {
+  using BenchFn = usize(*)(u8* dst, const u8* src, usize len);
+
+  enum class Prep : u8 {
+    None,
+    /// `dst` must match `src`.
+    Equal,
+    /// `src` must be a string of `len` characters.
+    String,
+  };
+
+  struct Kernel {
+    const char* name;
+    const char* impl;
+    Prep prep;
+    BenchFn fn;
+  };
+
+  struct Call {
+    u8* dst;
+    const u8* src;
+    usize len;
+  };
+
+  using bench::Stats;
+
+  struct Options {
+    const char* hist = nullptr;
+    const char* out = nullptr;
+    usize max = usize(256) << 20;
+    u32 reps = 101;
+    bool strategies = false;
+    bool check = false;
+  };
+
+  constexpr u8 kFill = 0x5A;
+  constexpr usize kPage = 4096;
+  constexpr usize kRealisticCalls = 4096;
+  /// Present in the haystack every 16 bytes, but never matches.
+  constexpr const char* kNeedle = "abcdefghijklmnoq";
+
+  /// src/dst offsets from a page boundary.
+  constexpr struct { usize src, dst; } kAligns[] {
+    {0, 0}, {1, 0}, {0, 1}, {15, 33}, {63, 63},
+  };
+
+} // namespace `anonymous`
+
+//======================================================================//
+// Kernels
+//======================================================================//
+
+namespace {
+  [[gnu::noinline]] usize hc_memcpy(u8* dst, const u8* src, usize len) {
+    com::inline_memcpy(dst, src, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize libc_memcpy(u8* dst, const u8* src, usize len) {
+    std::memcpy(dst, src, len);
+    return 0;
+  }
+
+  [[gnu::noinline]] usize hc_memset(u8* dst, const u8*, usize len) {
+    com::inline_memset(dst, kFill, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize libc_memset(u8* dst, const u8*, usize len) {
+    std::memset(dst, kFill, len);
+    return 0;
+  }
+
+  [[gnu::noinline]] usize hc_memcmp(u8* dst, const u8* src, usize len) {
+    return usize(com::inline_memcmp(dst, src, len));
+  }
+  [[gnu::noinline]] usize libc_memcmp(u8* dst, const u8* src, usize len) {
+    return usize(std::memcmp(dst, src, len));
+  }
+
+  [[gnu::noinline]] usize hc_strlen(u8*, const u8* src, usize) {
+    return xcrt::stringlen(reinterpret_cast<const char*>(src));
+  }
+  [[gnu::noinline]] usize libc_strlen(u8*, const u8* src, usize) {
+    return std::strlen(reinterpret_cast<const char*>(src));
+  }
+
+  /// `xcrt::strstr` runs `stringlen` first, which would be timed on
+  /// only one side. The harness knows the length, so it's passed in.
+  [[gnu::noinline]] usize hc_strstr(u8*, const u8* src, usize len) {
+    auto* const S = reinterpret_cast<const char*>(src);
+    return uptr(xcrt::find_first_str(S, kNeedle, len));
+  }
+  [[gnu::noinline]] usize libc_strstr(u8*, const u8* src, usize) {
+    auto* const S = reinterpret_cast<const char*>(src);
+    return uptr(std::strstr(S, kNeedle));
+  }
+
+  constexpr Kernel kKernels[] {
+    {"memcpy", "hc",   Prep::None,   &hc_memcpy},
+    {"memcpy", "libc", Prep::None,   &libc_memcpy},
+    {"memset", "hc",   Prep::None,   &hc_memset},
+    {"memset", "libc", Prep::None,   &libc_memset},
+    {"memcmp", "hc",   Prep::Equal,  &hc_memcmp},
+    {"memcmp", "libc", Prep::Equal,  &libc_memcmp},
+    {"strlen", "hc",   Prep::String, &hc_strlen},
+    {"strlen", "libc", Prep::String, &libc_strlen},
+    {"strstr", "hc",   Prep::String, &hc_strstr},
+    {"strstr", "libc", Prep::String, &libc_strstr},
+  };
+} // namespace `anonymous`
+
+//======================================================================//
+// Strategies
+//======================================================================//
+
+namespace {
+  /// What the untuned dispatch uses under the thresholds.
+  [[gnu::noinline]] usize copy_blocks(u8* dst, const u8* src, usize len) {
+    rt::__copy_aligned_blocks<32>(dst, src, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize copy_rep_movsb(u8* dst, const u8* src, usize len) {
+    rt::__copy_rep_movsb(dst, src, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize copy_nontemporal(u8* dst, const u8* src, usize len) {
+    rt::__copy_nontemporal(dst, src, len);
+    return 0;
+  }
+
+  [[gnu::noinline]] usize set_loop(u8* dst, const u8*, usize len) {
+    rt::__set_block<rt::v256>(dst, kFill);
+    rt::align_to_next_boundary<32>(dst, len);
+    rt::__set_loop_and_last<rt::v256>(dst, kFill, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize set_prefetching(u8* dst, const u8*, usize len) {
+    rt::__prefetching_memset(dst, kFill, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize set_rep_stosb(u8* dst, const u8*, usize len) {
+    rt::__set_rep_stosb(dst, kFill, len);
+    return 0;
+  }
+  [[gnu::noinline]] usize set_nontemporal(u8* dst, const u8*, usize len) {
+    rt::__set_nontemporal(dst, kFill, len);
+    return 0;
+  }
+
+  /// Strategies are compared within their group. The string
+  /// instruction is `rep`, and the streaming one is always last.
+  struct StrategyGroup {
+    const char* name;
+    const Kernel* strategies;
+    usize count;
+    usize rep;
+  };
+
+  constexpr Kernel kCopyStrategies[] {
+    {"memcpy", "aligned_blocks<32>", Prep::None, &copy_blocks},
+    {"memcpy", "rep_movsb",          Prep::None, &copy_rep_movsb},
+    {"memcpy", "nontemporal",        Prep::None, &copy_nontemporal},
+  };
+
+  constexpr Kernel kSetStrategies[] {
+    {"memset", "loop<v256>",  Prep::None, &set_loop},
+    {"memset", "prefetching", Prep::None, &set_prefetching},
+    {"memset", "rep_stosb",   Prep::None, &set_rep_stosb},
+    {"memset", "nontemporal", Prep::None, &set_nontemporal},
+  };
+
+  constexpr StrategyGroup kStrategyGroups[] {
+    {"memcpy", kCopyStrategies,
+      sizeof(kCopyStrategies) / sizeof(Kernel), 1},
+    {"memset", kSetStrategies,
+      sizeof(kSetStrategies) / sizeof(Kernel), 2},
+  };
+
+  constexpr usize kMaxStrategies = 4;
+  /// Two steps per octave from 128 bytes to the top of `usize`.
+  constexpr usize kMaxSweep = 2 * (sizeof(usize) * 8);
+
+  /// The median cycles of each strategy at each swept size.
+  struct Sweep {
+    usize sizes[kMaxSweep] {};
+    double cycles[kMaxStrategies][kMaxSweep] {};
+    usize count = 0;
+  public:
+    /// @return `true` if `S` beats every other strategy at `Ix`.
+    bool wins(usize S, usize Ix, usize strategies) const {
+      for (usize Ox = 0; Ox < strategies; ++Ox) {
+        if (Ox != S && cycles[Ox][Ix] <= cycles[S][Ix])
+          return false;
+      }
+      return true;
+    }
+
+    /// Finds the longest run of sizes where `S` wins.
+    /// @return `false` if it never wins.
+    bool longestWin(usize S, usize strategies, usize& lo, usize& hi) const {
+      usize best = 0;
+      for (usize Ix = 0; Ix < count;) {
+        if (!this->wins(S, Ix, strategies)) {
+          ++Ix;
+          continue;
+        }
+        usize end = Ix;
+        while (end + 1 < count && this->wins(S, end + 1, strategies))
+          ++end;
+        if (end - Ix + 1 > best)
+          best = end - Ix + 1, lo = Ix, hi = end;
+        Ix = end + 1;
+      }
+      return best != 0;
+    }
+
+    /// @return The first size from which `S` always wins,
+    /// or `count` if it doesn't win at the largest size.
+    usize winsFrom(usize S, usize strategies) const {
+      usize Ix = count;
+      while (Ix > 0 && this->wins(S, Ix - 1, strategies))
+        --Ix;
+      return Ix;
+    }
+  };
+} // namespace `anonymous`
+
+//======================================================================//
+// Measurement
+//======================================================================//
+
+namespace {
+  /// Runs `calls` `iters` times per sample.
+  /// @return Cycles per unit, over `units` per pass.
+  Stats measure(const Kernel& K, const Call* calls, usize count,
+   u32 iters, u32 reps, double units, double* samples) {
+    usize acc = 0;
+    // Warm up the caches and predictors.
+    for (usize Ix = 0; Ix < count; ++Ix)
+      acc += K.fn(calls[Ix].dst, calls[Ix].src, calls[Ix].len);
+    for (u32 R = 0; R < reps; ++R) {
+      const u64 start = bench::now();
+      for (u32 It = 0; It < iters; ++It) {
+        for (usize Ix = 0; Ix < count; ++Ix)
+          acc += K.fn(calls[Ix].dst, calls[Ix].src, calls[Ix].len);
+      }
+      const u64 end = bench::now();
+      samples[R] = double(end - start) / (double(iters) * units);
+    }
+    bench::consume(acc);
+    return bench::summarize(samples, reps);
+  }
+
+  /// Enough iterations that each sample is well above timer noise.
+  u32 iterations_for(usize bytes) {
+    constexpr usize target = usize(256) << 10;
+    const usize iters = target / (bytes + 64);
+    if (iters < 1)
+      return 1;
+    return u32(iters > 4096 ? 4096 : iters);
+  }
+
+  u32 reps_for(usize len, u32 reps) {
+    // Keep the large sweeps from taking minutes.
+    if (len >= (usize(1) << 24))
+      return reps < 11 ? reps : 11;
+    if (len >= (usize(1) << 20))
+      return reps < 31 ? reps : 31;
+    return reps;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Buffers
+//======================================================================//
+
+namespace {
+  struct Buffers {
+    u8* src = nullptr;
+    u8* dst = nullptr;
+    /// Haystack, terminated in place by `run_size`.
+    u8* str = nullptr;
+    usize size = 0;
+  public:
+    bool init(usize max) {
+      this->size = ((max + kPage - 1) & ~(kPage - 1)) + 2 * kPage;
+      src = static_cast<u8*>(bench::aligned_alloc(kPage, size));
+      dst = static_cast<u8*>(bench::aligned_alloc(kPage, size));
+      str = static_cast<u8*>(bench::aligned_alloc(kPage, size));
+      if (!src || !dst || !str)
+        return false;
+      Buffers::FillString(src, size);
+      Buffers::FillString(str, size);
+      str[size - 1] = 0;
+      std::memset(dst, 0, size);
+      return true;
+    }
+
+    ~Buffers() {
+      bench::aligned_free(src);
+      bench::aligned_free(dst);
+      bench::aligned_free(str);
+    }
+
+    static u8 CharAt(usize Ix) {
+      return u8('a' + (Ix & 0xF));
+    }
+
+    static void FillString(u8* P, usize len) {
+      for (usize Ix = 0; Ix < len; ++Ix)
+        P[Ix] = CharAt(Ix);
+    }
+  };
+
+  /// One string per distinct length, each starting `off` bytes past
+  /// a page boundary, so the realistic rows keep their alignment.
+  struct StringPool {
+    u8* base = nullptr;
+    const u8* strs[Histogram::maxBins] {};
+    usize lens[Histogram::maxBins] {};
+    usize count = 0;
+  public:
+    bool init(const usize* sampled, usize n, usize off) {
+      this->reset();
+      for (usize Ix = 0; Ix < n; ++Ix) {
+        if (this->indexOf(sampled[Ix]) == count)
+          lens[count++] = sampled[Ix];
+      }
+      usize total = 0;
+      for (usize Ix = 0; Ix < count; ++Ix)
+        total += StringPool::SlotSize(lens[Ix], off);
+      base = static_cast<u8*>(bench::aligned_alloc(kPage, total));
+      if (!base)
+        return false;
+      u8* slot = base;
+      for (usize Ix = 0; Ix < count; ++Ix) {
+        u8* const S = slot + off;
+        Buffers::FillString(S, lens[Ix]);
+        S[lens[Ix]] = 0;
+        strs[Ix] = S;
+        slot += StringPool::SlotSize(lens[Ix], off);
+      }
+      return true;
+    }
+
+    const u8* find(usize len) const {
+      const usize Ix = this->indexOf(len);
+      return (Ix < count) ? strs[Ix] : nullptr;
+    }
+
+    usize indexOf(usize len) const {
+      usize Ix = 0;
+      while (Ix < count && lens[Ix] != len)
+        ++Ix;
+      return Ix;
+    }
+
+    void reset() {
+      bench::aligned_free(base);
+      this->base = nullptr;
+      this->count = 0;
+    }
+
+    ~StringPool() { this->reset(); }
+
+    static usize SlotSize(usize len, usize off) {
+      return (off + len + 1 + kPage - 1) & ~(kPage - 1);
+    }
+  };
+
+  /// Fixes up the buffers before a kernel runs over `C`.
+  void prepare(const Kernel& K, Call& C, const StringPool& P) {
+    if (K.prep == Prep::Equal)
+      std::memcpy(C.dst, C.src, C.len);
+    else if (K.prep == Prep::String)
+      C.src = P.find(C.len);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Check
+//======================================================================//
+
+namespace {
+  /// Never zero, and never part of the filler.
+  constexpr u8 kCheckNeedle = '~';
+  /// Failures past this are only counted.
+  constexpr usize kMaxReported = 16;
+
+  constexpr u8 kGuard = 0xEE;
+  /// Bytes checked on either side of `dst`.
+  constexpr usize kGuardSize = 64;
+  /// Past the line-by-line lengths, around pages and the prefetch.
+  constexpr usize kVerifyLens[] {
+    4095, 4097, 65536 + 17, (usize(1) << 20) + 33,
+  };
+  constexpr usize kVerifyMax = (usize(1) << 20) + 33;
+
+  /// Doesn't repeat within a block, unlike `Buffers::FillString`.
+  void fill_verify(u8* P, usize len) {
+    for (usize Ix = 0; Ix < len; ++Ix)
+      P[Ix] = u8(Ix * 7 + (Ix >> 8));
+  }
+
+  /// Runs `K` once, and compares `dst` with the source or fill.
+  /// The bytes around `dst` must be left alone.
+  bool verify_strategy(const Kernel& K, const Buffers& B,
+   usize src_off, usize dst_off, usize len) {
+    const bool fills = (std::strcmp(K.name, "memset") == 0);
+    u8* const D = B.dst + kGuardSize + dst_off;
+    const u8* const S = B.src + src_off;
+    std::memset(D - kGuardSize, kGuard, len + 2 * kGuardSize);
+    K.fn(D, S, len);
+    for (usize Ix = 0; Ix < len; ++Ix) {
+      if (D[Ix] != (fills ? kFill : S[Ix]))
+        return false;
+    }
+    for (usize Ix = 1; Ix <= kGuardSize; ++Ix) {
+      if (D[-isize(Ix)] != kGuard || D[len + Ix - 1] != kGuard)
+        return false;
+    }
+    return true;
+  }
+
+  /// Checks every strategy at each alignment, for every length from
+  /// 2 to 5 lines, so the streaming tails see every remainder.
+  /// @return The number of failures.
+  usize verify_strategies(Buffers& B) {
+    usize failed = 0;
+    auto verify = [&B, &failed](const Kernel& K, usize len) {
+      if (len + 2 * (kGuardSize + kPage) > B.size)
+        return;
+      for (const auto& A : kAligns) {
+        if __expect_true(verify_strategy(K, B, A.src, A.dst, len))
+          continue;
+        if (failed++ < kMaxReported) {
+          std::fprintf(stderr, "%s %s: wrong at %zu bytes, src %zu, "
+            "dst %zu.\n", K.name, K.impl, len, A.src, A.dst);
+        }
+      }
+    };
+    fill_verify(B.src, B.size);
+    for (const StrategyGroup& G : kStrategyGroups) {
+      for (usize Sx = 0; Sx < G.count; ++Sx) {
+        const Kernel& K = G.strategies[Sx];
+        for (usize len = 128; len <= 320; ++len)
+          verify(K, len);
+        for (usize len : kVerifyLens)
+          verify(K, len);
+      }
+    }
+    Buffers::FillString(B.src, B.size);
+    std::memset(B.dst, 0, B.size);
+    return failed;
+  }
+
+  /// Guarded pages for the string checks. The last page is unmapped,
+  /// so any scan reading past the one before it faults.
+  struct GuardedPages {
+    u8* base = nullptr;
+    /// The first byte of the unmapped page.
+    u8* guard = nullptr;
+    static constexpr usize kPages = 4;
+  public:
+    bool init() {
+      void* const raw = mmap(nullptr, (kPages + 1) * kPage,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED)
+        return false;
+      this->base = static_cast<u8*>(raw);
+      this->guard = base + kPages * kPage;
+      return mprotect(guard, kPage, PROT_NONE) == 0;
+    }
+
+    ~GuardedPages() {
+      if (base)
+        munmap(base, (kPages + 1) * kPage);
+    }
+  };
+
+  template <typename Char>
+  Char filler_at(usize Ix) {
+    return Char('a' + (Ix % 23));
+  }
+
+  // libc takes the narrow strings. `wchar_t` is 16 bits here, so the
+  // wide ones are checked against plain loops.
+
+  template <typename Char>
+  usize ref_strlen(const Char* S) {
+    if constexpr (sizeof(Char) == 1)
+      return std::strlen(S);
+    usize Ix = 0;
+    while (S[Ix] != Char(0))
+      ++Ix;
+    return Ix;
+  }
+
+  template <typename Char>
+  usize ref_strnlen(const Char* S, usize n) {
+    if constexpr (sizeof(Char) == 1)
+      return ::strnlen(S, n);
+    usize Ix = 0;
+    while (Ix < n && S[Ix] != Char(0))
+      ++Ix;
+    return Ix;
+  }
+
+  template <typename Char>
+  const void* ref_memchr(const Char* S, Char C, usize n) {
+    if constexpr (sizeof(Char) == 1)
+      return std::memchr(S, C, n);
+    for (usize Ix = 0; Ix < n; ++Ix) {
+      if (S[Ix] == C)
+        return S + Ix;
+    }
+    return nullptr;
+  }
+
+  template <typename Char>
+  const void* ref_strchr(const Char* S, Char C) {
+    if constexpr (sizeof(Char) == 1)
+      return std::strchr(S, C);
+    for (;; ++S) {
+      if (*S == C)
+        return S;
+      if (*S == Char(0))
+        return nullptr;
+    }
+  }
+
+  struct ScanCheck {
+    const char* name;
+    usize cases = 0;
+    usize failures = 0;
+  public:
+    /// Counts a case, reporting it unless `ok`.
+    void expect(bool ok, const char* kernel,
+     usize off, usize len, usize n) {
+      ++cases;
+      if __expect_true(ok)
+        return;
+      if (failures++ < kMaxReported) {
+        std::fprintf(stderr, "%s %s: offset %zu, length %zu, n %zu.\n",
+          name, kernel, off, len, n);
+      }
+    }
+  };
+
+  /// Runs every kernel over the string at `S`, and compares it with
+  /// libc. The bounded ones are run for every `n` up to `max_n`.
+  template <typename VecType, typename Char>
+  void check_string(ScanCheck& R, const Char* S,
+   usize off, usize len, usize max_n) {
+    const Char C = Char(kCheckNeedle);
+    R.expect(xcrt::xstringlen_vec_read<VecType>(S) == ref_strlen(S),
+      "strlen", off, len, 0);
+    for (usize n = 0; n <= max_n; ++n) {
+      R.expect(xcrt::xstringnlen_vec_read<VecType>(S, n)
+        == ref_strnlen(S, n), "strnlen", off, len, n);
+      R.expect(xcrt::xFFC_vec_read<VecType>(S, C, n)
+        == ref_memchr(S, C, n), "memchr", off, len, n);
+    }
+    R.expect(xcrt::xstrchr_vec_read<VecType>(S, C)
+      == ref_strchr(S, C), "strchr", off, len, 0);
+    R.expect(xcrt::xstrchr_vec_read<VecType>(S, Char(0))
+      == ref_strchr(S, Char(0)), "strchr(0)", off, len, 0);
+  }
+
+  /// Checks the vector scans at every start offset in a vector, for
+  /// lengths up to 3 vectors, then with the terminator or the needle
+  /// at the end of a page.
+  template <typename VecType, typename Char>
+  usize check_scans(const char* name, GuardedPages& G) {
+    using Scan = xcrt::VecScan<VecType, Char>;
+    constexpr usize kLanes = Scan::kLanes;
+    constexpr usize kMaxLen = 3 * kLanes;
+    const Char C = Char(kCheckNeedle);
+    ScanCheck R {name};
+
+    // Offsets within a vector. The lanes before `S` are all zeros or
+    // all needles, and must be dropped.
+    Char* const block = reinterpret_cast<Char*>(G.base + kPage);
+    for (usize off = 0; off < kLanes; ++off) {
+      Char* const S = block + off;
+      for (usize pre = 0; pre < 2; ++pre) {
+        for (usize Ix = 0; Ix < off; ++Ix)
+          block[Ix] = pre ? C : Char(0);
+        for (usize len = 0; len <= kMaxLen; ++len) {
+          for (usize Ix = 0; Ix < kMaxLen + 2 * kLanes; ++Ix)
+            S[Ix] = filler_at<Char>(Ix);
+          S[len] = Char(0);
+          check_string<VecType>(R, S, off, len, kMaxLen + 2);
+          // The needle at each position, over the terminator, and past it.
+          for (usize at = 0; at <= len + 1; ++at) {
+            const Char old = S[at];
+            S[at] = C;
+            check_string<VecType>(R, S, off, len, kMaxLen + 2);
+            S[at] = old;
+          }
+        }
+      }
+    }
+
+    // The terminator, then the needle, in the last lane of the page.
+    // `n` stops at the page, the scans must not read past it.
+    Char* const end = reinterpret_cast<Char*>(G.guard);
+    for (usize len = 0; len <= kMaxLen; ++len) {
+      Char* const S = end - (len + 1);
+      const usize off = Scan::Offset(S) / sizeof(Char);
+      for (usize Ix = 0; Ix < len; ++Ix)
+        S[Ix] = filler_at<Char>(Ix);
+      S[len] = Char(0);
+      check_string<VecType>(R, S, off, len, len + 1);
+      R.expect(xcrt::xstringnlen_vec_read<VecType>(S, usize(-1)) == len,
+        "strnlen", off, len, usize(-1));
+      S[len] = C;
+      R.expect(xcrt::xFFC_vec_read<VecType>(S, C, len + 1) == S + len,
+        "memchr", off, len, len + 1);
+      R.expect(xcrt::xFFC_vec_read<VecType>(S, C, len) == nullptr,
+        "memchr", off, len, len);
+      R.expect(xcrt::xstrchr_vec_read<VecType>(S, C) == S + len,
+        "strchr", off, len, 0);
+      R.expect(xcrt::xstringnlen_vec_read<VecType>(S, len + 1) == len + 1,
+        "strnlen", off, len, len + 1);
+    }
+
+    std::fprintf(stderr, "%s: %zu cases, %zu failures.\n",
+      name, R.cases, R.failures);
+    return R.failures;
+  }
+
+  using MoveFn = void(*)(u8* dst, const u8* src, usize len);
+
+  constexpr usize kMoveBlock = rt::__memmove_block_v;
+  constexpr usize kMoveArena = 4096;
+  /// Where `src` starts, leaving room for `dst` before it.
+  constexpr usize kMoveBase = 1024;
+
+  [[gnu::noinline]] void hc_memmove(u8* dst, const u8* src, usize len) {
+    com::inline_memmove(dst, src, len);
+  }
+
+  /// The byte-wise reference, copying away from the overlap.
+  void ref_memmove(u8* dst, const u8* src, usize len) {
+    if (dst < src) {
+      for (usize Ix = 0; Ix < len; ++Ix)
+        dst[Ix] = src[Ix];
+    } else {
+      for (usize Ix = len; Ix > 0; --Ix)
+        dst[Ix - 1] = src[Ix - 1];
+    }
+  }
+
+  /// Repeats every 256 bytes, so any shift within a block shows.
+  void fill_moves(u8* P) {
+    for (usize Ix = 0; Ix < kMoveArena; ++Ix)
+      P[Ix] = u8(Ix * 13 + 1);
+  }
+
+  struct MoveCheck {
+    u8 arena[kMoveArena];
+    u8 expected[kMoveArena];
+    usize cases = 0;
+    usize failures = 0;
+  public:
+    /// Moves `len` bytes by `dist`, and compares the whole arena
+    /// with the reference, so stray stores are caught too.
+    void run(const char* name, MoveFn fn,
+     usize off, usize len, isize dist) {
+      const usize src = kMoveBase + off;
+      const usize dst = usize(isize(src) + dist);
+      fill_moves(arena);
+      fill_moves(expected);
+      fn(arena + dst, arena + src, len);
+      ref_memmove(expected + dst, expected + src, len);
+      ++cases;
+      if __expect_true(std::memcmp(arena, expected, kMoveArena) == 0)
+        return;
+      if (failures++ < kMaxReported) {
+        std::fprintf(stderr, "%s: offset %zu, length %zu, distance %zd.\n",
+          name, off, len, dist);
+      }
+    }
+  };
+
+  /// Checks the block loops in their own directions for every overlap
+  /// up to 2 blocks, then `inline_memmove` across the 128 byte split.
+  usize check_moves() {
+    static MoveCheck M {};
+    constexpr MoveFn fwd = &rt::__move_blocks_fwd<kMoveBlock>;
+    constexpr MoveFn bwd = &rt::__move_blocks_bwd<kMoveBlock>;
+    constexpr usize kOffsets[] {0, 5};
+    for (usize off : kOffsets) {
+      for (usize len = kMoveBlock; len <= 4 * kMoveBlock + 1; ++len) {
+        for (usize D = 1; D <= 2 * kMoveBlock; ++D) {
+          M.run("move_blocks_fwd", fwd, off, len, -isize(D));
+          M.run("move_blocks_bwd", bwd, off, len, isize(D));
+        }
+      }
+      for (usize len = 1; len <= 3 * 128; ++len) {
+        for (usize D = 1; D <= 2 * kMoveBlock; ++D) {
+          M.run("memmove", &hc_memmove, off, len, -isize(D));
+          M.run("memmove", &hc_memmove, off, len, isize(D));
+        }
+        // Where the dispatch stops treating them as overlapping.
+        for (usize D = len - 1; D <= len + 1; ++D) {
+          if (D == 0)
+            continue;
+          M.run("memmove", &hc_memmove, off, len, -isize(D));
+          M.run("memmove", &hc_memmove, off, len, isize(D));
+        }
+      }
+    }
+    std::fprintf(stderr, "memmove: %zu cases, %zu failures.\n",
+      M.cases, M.failures);
+    return M.failures;
+  }
+
+  int check() {
+    GuardedPages G {};
+    if (!G.init()) {
+      std::fprintf(stderr, "Unable to map the guarded pages.\n");
+      return 1;
+    }
+    usize failed = 0;
+    failed += check_scans<rt::Gv128, char>("Gv128<char>", G);
+    failed += check_scans<rt::Gv128, wchar_t>("Gv128<wchar_t>", G);
+    failed += check_scans<rt::Gv256, char>("Gv256<char>", G);
+    failed += check_scans<rt::Gv256, wchar_t>("Gv256<wchar_t>", G);
+    failed += check_moves();
+    Buffers B {};
+    if (!B.init(kVerifyMax)) {
+      std::fprintf(stderr, "Unable to allocate %zu bytes.\n", kVerifyMax);
+      return 1;
+    }
+    const usize wrong = verify_strategies(B);
+    std::fprintf(stderr, "strategies: %zu failures.\n", wrong);
+    failed += wrong;
+    std::fprintf(stderr, "%zu failures.\n", failed);
+    return failed ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Driver
+//======================================================================//
+
+namespace {
+  FILE* __out_ = stdout;
+
+  void emit(const Kernel& K, const char* dist, usize len,
+   usize src_off, usize dst_off, Stats cycles, Stats cpb) {
+    std::fprintf(__out_, "%s,%s,%s,%zu,%zu,%zu,%.2f,%.2f,%.4f,%.4f\n",
+      K.name, K.impl, dist, len, src_off, dst_off,
+      cycles.median, cycles.p99, cpb.median, cpb.p99);
+  }
+
+  void run_size(const char* dist, usize len,
+   const Options& O, Buffers& B, double* samples) {
+    for (const auto& A : kAligns) {
+      for (const Kernel& K : kKernels) {
+        Call C {B.dst + A.dst, B.src + A.src, len};
+        // Terminate the string in place, so it keeps the alignment.
+        u8* term = nullptr;
+        if (K.prep == Prep::String) {
+          term = B.str + A.src + len;
+          C.src = B.str + A.src;
+          *term = 0;
+        } else if (K.prep == Prep::Equal) {
+          std::memcpy(C.dst, C.src, C.len);
+        }
+        const u32 iters = iterations_for(len);
+        const u32 reps  = reps_for(len, O.reps);
+        const Stats cycles = measure(K, &C, 1, iters, reps, 1.0, samples);
+        if (term)
+          *term = Buffers::CharAt(A.src + len);
+        Stats cpb {};
+        if (len != 0)
+          cpb = {cycles.median / double(len), cycles.p99 / double(len)};
+        emit(K, dist, len, A.src, A.dst, cycles, cpb);
+      }
+    }
+  }
+
+  void run_realistic(const Histogram& H,
+   const Options& O, Buffers& B, double* samples) {
+    static Call calls[kRealisticCalls];
+    usize lens[kRealisticCalls];
+    H.sample(lens, kRealisticCalls, O.max);
+    static StringPool P {};
+    usize total = 0;
+    for (usize len : lens)
+      total += len;
+    for (const auto& A : kAligns) {
+      if (!P.init(lens, kRealisticCalls, A.src)) {
+        std::fprintf(stderr, "Unable to allocate the string pool.\n");
+        return;
+      }
+      for (const Kernel& K : kKernels) {
+        for (usize Ix = 0; Ix < kRealisticCalls; ++Ix) {
+          calls[Ix] = {B.dst + A.dst, B.src + A.src, lens[Ix]};
+          prepare(K, calls[Ix], P);
+        }
+        const double units = double(total ? total : 1);
+        const Stats cpb = measure(K, calls,
+          kRealisticCalls, 1, O.reps, units, samples);
+        const double per_call = units / double(kRealisticCalls);
+        const Stats cycles {cpb.median * per_call, cpb.p99 * per_call};
+        emit(K, "realistic", total / kRealisticCalls,
+          A.src, A.dst, cycles, cpb);
+      }
+    }
+  }
+
+  /// Prints where streaming takes over, and the divisor that
+  /// puts `nt_threshold` there on this machine.
+  void report_nontemporal(const StrategyGroup& G, const Sweep& S, u64 llc) {
+    const usize nt = G.count - 1;
+    if (S.count == 0)
+      return;
+    const usize from = S.winsFrom(nt, G.count);
+    if (from == S.count) {
+      std::fprintf(stderr, "%s: %s never wins up to %zu bytes.\n",
+        G.name, G.strategies[nt].impl, S.sizes[S.count - 1]);
+      return;
+    }
+    const usize size = S.sizes[from];
+    std::fprintf(stderr, "%s: %s wins from %zu bytes",
+      G.name, G.strategies[nt].impl, size);
+    if (llc == 0) {
+      std::fprintf(stderr, ", the LLC size is unknown.\n");
+      return;
+    }
+    // Round to the nearest power of 2, `nt_threshold` is a fraction.
+    u64 div = 1;
+    while (div < 64 && (llc / (div * 2)) >= (size - size / 4))
+      div *= 2;
+    std::fprintf(stderr, ", RT_NONTEMPORAL_DIV=%llu (llc/%llu = %llu).\n",
+      (unsigned long long)div, (unsigned long long)div,
+      (unsigned long long)(llc / div));
+  }
+
+  /// Prints where the string instruction beats the block loops,
+  /// ignoring streaming. The start is the probe's threshold.
+  void report_rep(const StrategyGroup& G, const Sweep& S) {
+    usize lo = 0, hi = 0;
+    const Kernel& K = G.strategies[G.rep];
+    if (!S.longestWin(G.rep, G.count - 1, lo, hi)) {
+      std::fprintf(stderr, "%s: %s never beats the loops.\n",
+        G.name, K.impl);
+      return;
+    }
+    std::fprintf(stderr, "%s: %s wins from %zu to %zu bytes",
+      G.name, K.impl, S.sizes[lo], S.sizes[hi]);
+    if (hi + 1 < S.count)
+      std::fprintf(stderr, ", and loses above it.\n");
+    else
+      std::fprintf(stderr, ".\n");
+  }
+
+  /// Times every strategy from 128 bytes to `O.max`, aligned.
+  /// The last strategy in each group is the streaming one.
+  /// @return `false` if a strategy gave the wrong result.
+  bool run_strategies(const Options& O, Buffers& B, double* samples) {
+    if (verify_strategies(B) != 0) {
+      std::fprintf(stderr, "Not timing broken strategies.\n");
+      return false;
+    }
+    static Sweep S {};
+    const u64 llc = rt::cpu_features().llc_size;
+    for (const StrategyGroup& G : kStrategyGroups) {
+      S.count = 0;
+      for (usize len = 128; len <= O.max && S.count < kMaxSweep;) {
+        const usize Ix = S.count++;
+        S.sizes[Ix] = len;
+        for (usize Sx = 0; Sx < G.count; ++Sx) {
+          const Kernel& K = G.strategies[Sx];
+          Call C {B.dst, B.src, len};
+          const u32 iters = iterations_for(len);
+          const u32 reps  = reps_for(len, O.reps);
+          const Stats cycles = measure(K, &C, 1, iters, reps, 1.0, samples);
+          S.cycles[Sx][Ix] = cycles.median;
+          const Stats cpb {cycles.median / double(len),
+            cycles.p99 / double(len)};
+          emit(K, "strategy", len, 0, 0, cycles, cpb);
+        }
+        // Steps of 1.5x then 1.33x, so each octave has two sizes.
+        len = ((len & (len - 1)) == 0) ? len + len / 2 : len + len / 3;
+      }
+      report_rep(G, S);
+      report_nontemporal(G, S, llc);
+    }
+    return true;
+  }
+
+  bool parse_args(int argc, char** argv, Options& O) {
+    for (int Ix = 1; Ix < argc; ++Ix) {
+      const char* arg = argv[Ix];
+      if (std::strcmp(arg, "--strategies") == 0) {
+        O.strategies = true;
+        continue;
+      }
+      if (std::strcmp(arg, "--check") == 0) {
+        O.check = true;
+        continue;
+      }
+      const char* val = (Ix + 1 < argc) ? argv[Ix + 1] : nullptr;
+      if (!val) {
+        std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+        return false;
+      }
+      if (std::strcmp(arg, "--hist") == 0)
+        O.hist = val;
+      else if (std::strcmp(arg, "--out") == 0)
+        O.out = val;
+      else if (std::strcmp(arg, "--max") == 0)
+        O.max = usize(std::strtoull(val, nullptr, 0));
+      else if (std::strcmp(arg, "--reps") == 0)
+        O.reps = u32(std::strtoul(val, nullptr, 0));
+      else {
+        std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+        return false;
+      }
+      ++Ix;
+    }
+    if (O.reps == 0)
+      O.reps = 1;
+    return true;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  Options O {};
+  if (!parse_args(argc, argv, O))
+    return 1;
+  if (O.check)
+    return check();
+
+  Histogram H {};
+  if (O.hist ? !H.load(O.hist) : !H.loadDefault()) {
+    std::fprintf(stderr, "Unable to load histogram '%s'.\n", O.hist);
+    return 1;
+  }
+
+  Buffers B {};
+  if (!B.init(O.max)) {
+    std::fprintf(stderr, "Unable to allocate %zu bytes.\n", O.max);
+    return 1;
+  }
+
+  if (O.out && !(__out_ = std::fopen(O.out, "w"))) {
+    std::fprintf(stderr, "Unable to open '%s'.\n", O.out);
+    return 1;
+  }
+
+  const auto& F = rt::cpu_features();
+  std::fprintf(stderr, "llc: %llu, nt: %zu, movsb: %zu, stosb: %zu\n",
+    (unsigned long long)F.llc_size, F.nt_threshold,
+    F.rep_movsb_threshold, F.rep_stosb_threshold);
+
+  auto* samples = static_cast<double*>(
+    std::malloc(sizeof(double) * O.reps));
+  std::fprintf(__out_, "kernel,impl,dist,size,src_align,dst_align,"
+    "median_cycles,p99_cycles,median_cpb,p99_cpb\n");
+
+  if (O.strategies) {
+    const bool ok = run_strategies(O, B, samples);
+    std::free(samples);
+    if (__out_ != stdout)
+      std::fclose(__out_);
+    return ok ? 0 : 1;
+  }
+
+  // Fixed sizes: every size to 16, then half powers of 2 up to 4 KiB.
+  for (usize len = 0; len <= 16; ++len)
+    run_size("fixed", len, O, B, samples);
+  for (usize len = 32; len <= 4096; len *= 2) {
+    run_size("fixed", len - (len / 4), O, B, samples);
+    run_size("fixed", len, O, B, samples);
+  }
+
+  // Log sweep from 4 KiB.
+  for (usize len = 8192; len <= O.max; len *= 2)
+    run_size("log", len, O, B, samples);
+
+  run_realistic(H, O, B, samples);
+
+  std::free(samples);
+  if (__out_ != stdout)
+    std::fclose(__out_);
+  return 0;
+}
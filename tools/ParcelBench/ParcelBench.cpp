@@ -0,0 +1,485 @@
+//===- ParcelBench.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Host benchmark for `StaticHashMap` against a sorted `StaticVec`,
+//  the lookup it usually replaces. Both are timed with integer and
+//  string keys from 16 to 4096 entries, half of the queries misses,
+//  and building each from unordered keys. Results are written as CSV.
+//
+//  With `--check`, it instead runs the `BitOps` kernels behind `BitList`
+//  and `BitSet`, and compares them with the per-bit constant evaluated
+//  paths, over every split between the vector loops and the tail.
+//
+//  Usage: hc-parcel-bench [--reps <n>] [--out <file>]
+//         hc-parcel-bench --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <Bench.hpp>
+
+#include <Parcel/BitSet.hpp>
+#include <Parcel/StaticHashMap.hpp>
+#include <Parcel/StaticVec.hpp>
+
+using namespace hc;
+using namespace hc::parcel;
+
+namespace {
+  constexpr usize kMaxEntries = 4096;
+  constexpr usize kQueries = 4096;
+
+  struct Options {
+    const char* out = nullptr;
+    u32 reps = 31;
+    bool check = false;
+  };
+
+  FILE* __out_ = stdout;
+
+  void emit(const char* bench, const char* container,
+   usize entries, bench::Stats cycles) {
+    std::fprintf(__out_, "%s,%s,%zu,%.2f,%.2f\n",
+      bench, container, entries, cycles.median, cycles.p99);
+  }
+
+  /// The smallest power of 2 which keeps `count` under the max load.
+  constexpr usize hash_slots(usize count) {
+    usize N = 16;
+    while (N - (N / 8) < count)
+      N *= 2;
+    return N;
+  }
+
+  template <typename K>
+  struct Entry {
+    K key;
+    u32 value;
+  };
+} // namespace `anonymous`
+
+//======================================================================//
+// Keys
+//======================================================================//
+
+namespace {
+  u64 __state_ = 0x9E3779B97F4A7C15ULL;
+
+  u64 next_random() {
+    __state_ ^= __state_ << 13;
+    __state_ ^= __state_ >> 7;
+    __state_ ^= __state_ << 17;
+    return __state_;
+  }
+
+  /// Identifier-like strings, between 8 and 27 characters.
+  struct KeySet {
+    static constexpr usize kMaxLen = 27;
+    u64 ints[kMaxEntries] {};
+    u64 intMisses[kMaxEntries] {};
+    char data[2 * kMaxEntries * (kMaxLen + 1)] {};
+    com::StrRef strs[kMaxEntries] {};
+    com::StrRef strMisses[kMaxEntries] {};
+  public:
+    /// Deterministic, so runs can be compared. Hits have the low bit
+    /// clear and misses have it set, so they never collide.
+    void init() {
+      char* P = data;
+      for (usize Ix = 0; Ix < kMaxEntries; ++Ix) {
+        ints[Ix] = next_random() & ~u64(1);
+        intMisses[Ix] = next_random() | u64(1);
+        strs[Ix] = make_string(P, Ix, 'a');
+        P += kMaxLen + 1;
+        strMisses[Ix] = make_string(P, Ix, 'A');
+        P += kMaxLen + 1;
+      }
+    }
+
+  private:
+    /// Unique, since the index is spelled out in the first 4 characters.
+    /// The last character separates hits from misses.
+    static com::StrRef make_string(char* P, usize Ix, char last) {
+      static constexpr char kChars[]
+        = "abcdefghijklmnopqrstuvwxyz_0123456789";
+      static constexpr char kHex[] = "0123456789abcdef";
+      const usize len = 8 + (next_random() % (kMaxLen - 7));
+      for (usize Cx = 0; Cx < 4; ++Cx)
+        P[Cx] = kHex[(Ix >> (Cx * 4)) & 0xF];
+      for (usize Cx = 4; Cx < len - 1; ++Cx)
+        P[Cx] = kChars[next_random() % (sizeof(kChars) - 1)];
+      P[len - 1] = last;
+      return com::StrRef::New(P, len);
+    }
+  };
+
+  KeySet __keys_ {};
+
+  const u64* hits(u64*) { return __keys_.ints; }
+  const u64* misses(u64*) { return __keys_.intMisses; }
+  const com::StrRef* hits(com::StrRef*) { return __keys_.strs; }
+  const com::StrRef* misses(com::StrRef*) { return __keys_.strMisses; }
+
+  /// Alternates hits and misses from the first `count` keys.
+  template <typename K>
+  void make_queries(K* out, usize count) {
+    const K* const H = hits(static_cast<K*>(nullptr));
+    const K* const M = misses(static_cast<K*>(nullptr));
+    for (usize Ix = 0; Ix < kQueries; ++Ix) {
+      const usize Kx = usize(next_random() % count);
+      out[Ix] = (Ix & 1) ? M[Kx] : H[Kx];
+    }
+  }
+
+  bool key_less(u64 lhs, u64 rhs) {
+    return lhs < rhs;
+  }
+
+  /// Length first, the same as the string tables.
+  bool key_less(com::StrRef lhs, com::StrRef rhs) {
+    if (lhs.size() != rhs.size())
+      return lhs.size() < rhs.size();
+    return std::memcmp(lhs.data(), rhs.data(), lhs.size()) < 0;
+  }
+
+  template <typename K>
+  int cmp_entries(const void* lhs, const void* rhs) {
+    const K& L = static_cast<const Entry<K>*>(lhs)->key;
+    const K& R = static_cast<const Entry<K>*>(rhs)->key;
+    return int(key_less(R, L)) - int(key_less(L, R));
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Containers
+//======================================================================//
+
+namespace {
+  template <typename K, usize Count>
+  struct SortedVec {
+    StaticVec<Entry<K>, Count> vec {};
+  public:
+    void build(const K* keys) {
+      vec.clear();
+      for (usize Ix = 0; Ix < Count; ++Ix)
+        vec.push({keys[Ix], u32(Ix)});
+      std::qsort(vec.data(), vec.size(), sizeof(Entry<K>), &cmp_entries<K>);
+    }
+
+    /// Branchless lower bound.
+    const u32* find(const K& key) const {
+      const Entry<K>* base = vec.data();
+      usize n = vec.size();
+      while (n > 1) {
+        const usize half = n / 2;
+        base = key_less(base[half - 1].key, key) ? base + half : base;
+        n -= half;
+      }
+      return (base->key == key) ? &base->value : nullptr;
+    }
+  };
+
+  template <typename K, usize Count>
+  struct HashMap {
+    StaticHashMap<K, u32, hash_slots(Count)> map {};
+  public:
+    void build(const K* keys) {
+      map.clear();
+      for (usize Ix = 0; Ix < Count; ++Ix)
+        (void) map.insert(keys[Ix], u32(Ix));
+    }
+
+    const u32* find(const K& key) const {
+      return map.find(key);
+    }
+  };
+
+  /// @return Cycles per lookup.
+  template <typename C, typename K>
+  bench::Stats time_lookups(const C& container, const K* queries,
+   u32 reps, double* samples, usize& found) {
+    found = 0;
+    for (usize Ix = 0; Ix < kQueries; ++Ix)
+      found += (container.find(queries[Ix]) != nullptr);
+    return bench::measure([&] {
+      usize sum = 0;
+      for (usize Ix = 0; Ix < kQueries; ++Ix) {
+        if (const u32* V = container.find(queries[Ix]))
+          sum += *V;
+      }
+      bench::consume(sum);
+    }, reps, double(kQueries), samples);
+  }
+
+  /// @return Cycles per entry.
+  template <typename C, typename K>
+  bench::Stats time_build(C& container, const K* keys,
+   usize count, u32 reps, double* samples) {
+    return bench::measure([&] {
+      container.build(keys);
+    }, reps, double(count), samples);
+  }
+
+  template <typename K, usize Count>
+  bool run_size(const char* suffix, const Options& O, double* samples) {
+    static SortedVec<K, Count> sorted {};
+    static HashMap<K, Count> hashed {};
+    static K queries[kQueries] {};
+    const K* const keys = hits(static_cast<K*>(nullptr));
+    sorted.build(keys);
+    hashed.build(keys);
+    make_queries(queries, Count);
+
+    char bench[32];
+    usize sorted_found = 0, hashed_found = 0;
+    std::snprintf(bench, sizeof(bench), "lookup-%s", suffix);
+    emit(bench, "sorted", Count,
+      time_lookups(sorted, queries, O.reps, samples, sorted_found));
+    emit(bench, "hashed", Count,
+      time_lookups(hashed, queries, O.reps, samples, hashed_found));
+    // Every hit should be found, and no misses.
+    if (sorted_found != kQueries / 2 || hashed_found != kQueries / 2) {
+      std::fprintf(stderr, "Found %zu and %zu of %zu %s keys.\n",
+        sorted_found, hashed_found, kQueries / 2, suffix);
+      return false;
+    }
+
+    std::snprintf(bench, sizeof(bench), "build-%s", suffix);
+    emit(bench, "sorted", Count,
+      time_build(sorted, keys, Count, O.reps, samples));
+    emit(bench, "hashed", Count,
+      time_build(hashed, keys, Count, O.reps, samples));
+    return true;
+  }
+
+  template <typename K>
+  bool run_keys(const char* suffix, const Options& O, double* samples) {
+    return run_size<K, 16>(suffix, O, samples)
+        && run_size<K, 64>(suffix, O, samples)
+        && run_size<K, 256>(suffix, O, samples)
+        && run_size<K, 1024>(suffix, O, samples)
+        && run_size<K, kMaxEntries>(suffix, O, samples);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Bits
+//======================================================================//
+
+namespace {
+  constexpr usize kBitRanges = 12;
+  constexpr usize kBitProbes = 16;
+  /// And, Or, Xor, AndNot, then each range set and cleared.
+  constexpr usize kBitLists = 4 + 2 * kBitRanges;
+
+  /// The same at compile time and at runtime, unlike `next_random`.
+  constexpr u64 mix_bits(u64 X) {
+    X += 0x9E3779B97F4A7C15ULL;
+    X = (X ^ (X >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    X = (X ^ (X >> 27)) * 0x94D049BB133111EBULL;
+    return X ^ (X >> 31);
+  }
+
+  /// Where each result came from, and everything it produced.
+  template <usize N>
+  struct BitResults {
+    static constexpr usize kWords = BitList<N>::__USize();
+  public:
+    u64 words[kBitLists][kWords] {};
+    usize counts[kBitLists] {};
+    isize next[kBitProbes] {};
+    /// A flipped `BitSet`, whose padding must stay clear.
+    u64 flipped[kWords] {};
+    usize flipped_count = 0;
+    isize flipped_next = 0;
+  };
+
+  template <usize N>
+  constexpr void fill_bits(BitList<N>& L, u64 seed) {
+    for (usize I = 0; I < N; ++I) {
+      if (mix_bits(seed + I) & 0x1)
+        L.set(I);
+    }
+  }
+
+  template <usize N>
+  constexpr void save_bits(BitResults<N>& R, usize Ix, BitList<N>& L) {
+    for (usize W = 0; W < BitResults<N>::kWords; ++W)
+      R.words[Ix][W] = L.__uData()[W];
+    R.counts[Ix] = L.countActive();
+  }
+
+  /// Runs every bulk operation. At compile time this takes the per-bit
+  /// paths, at runtime the `BitOps` kernels.
+  template <usize N>
+  constexpr BitResults<N> run_bits(u64 seed) {
+    BitResults<N> R {};
+    BitList<N> lhs {}, rhs {};
+    fill_bits(lhs, seed);
+    fill_bits(rhs, seed + N);
+
+    BitList<N> L = lhs;
+    save_bits(R, 0, L &= rhs);
+    L = lhs;
+    save_bits(R, 1, L |= rhs);
+    L = lhs;
+    save_bits(R, 2, L ^= rhs);
+    L = lhs;
+    save_bits(R, 3, L.andNot(rhs));
+
+    // Word boundaries, `end % 64 == 0`, and runs past a vector.
+    constexpr usize ranges[kBitRanges][2] {
+      {0, 0}, {0, N}, {1, 63}, {63, 65}, {0, 64}, {64, 128},
+      {3, N - (N % 64)}, {N / 3, N}, {N / 2, N / 2 + 1},
+      {65, 64 * 9}, {127, 64 * 17 + 1}, {N - 1, N},
+    };
+    for (usize Ix = 0; Ix < kBitRanges; ++Ix) {
+      const usize end = (ranges[Ix][1] < N) ? ranges[Ix][1] : N;
+      const usize begin = (ranges[Ix][0] < end) ? ranges[Ix][0] : end;
+      L = lhs;
+      save_bits(R, 4 + 2 * Ix, L.setRange(begin, end));
+      L = lhs;
+      save_bits(R, 5 + 2 * Ix, L.clearRange(begin, end));
+    }
+
+    // Two bits, so whole blocks are skipped.
+    BitList<N> sparse {};
+    sparse.set(N - 1);
+    if (N / 2 + 3 < N)
+      sparse.set(N / 2 + 3);
+    constexpr usize probes[kBitProbes] {
+      0, 1, 63, 64, 65, 511, 512, 513,
+      N / 2, N / 2 + 3, N / 2 + 4, N - 2, N - 1, N, 64 * 9, 64 * 17,
+    };
+    for (usize Ix = 0; Ix < kBitProbes; ++Ix) {
+      const usize from = (probes[Ix] < N) ? probes[Ix] : N;
+      R.next[Ix] = sparse.findNextSet(from);
+    }
+
+    BitSet<N> S {};
+    for (usize I = 0; I < N; ++I) {
+      if (lhs.get(I))
+        S.set(I);
+    }
+    S.flip();
+    for (usize W = 0; W < BitResults<N>::kWords; ++W)
+      R.flipped[W] = S.__uData()[W];
+    R.flipped_count = S.count();
+    R.flipped_next = S.findNextSet(N - 1);
+    return R;
+  }
+
+  /// Read at runtime, so `run_bits` can't be constant evaluated.
+  u64 __bit_seed_ = 0x5EED;
+
+  template <usize N>
+  usize check_bits() {
+    static constexpr BitResults<N> expected = run_bits<N>(0x5EED);
+    const BitResults<N> got = run_bits<N>(__bit_seed_);
+    usize failed = 0;
+    auto expect = [&failed](bool ok, const char* what, usize Ix) {
+      if __expect_true(ok)
+        return;
+      ++failed;
+      std::fprintf(stderr, "BitList<%zu>: %s %zu differs.\n", N, what, Ix);
+    };
+    for (usize Ix = 0; Ix < kBitLists; ++Ix) {
+      for (usize W = 0; W < BitResults<N>::kWords; ++W)
+        expect(got.words[Ix][W] == expected.words[Ix][W], "list", Ix);
+      expect(got.counts[Ix] == expected.counts[Ix], "count", Ix);
+    }
+    for (usize Ix = 0; Ix < kBitProbes; ++Ix)
+      expect(got.next[Ix] == expected.next[Ix], "probe", Ix);
+    for (usize W = 0; W < BitResults<N>::kWords; ++W)
+      expect(got.flipped[W] == expected.flipped[W], "flipped word", W);
+    expect(got.flipped_count == expected.flipped_count, "flipped count", 0);
+    expect(got.flipped_next == expected.flipped_next, "flipped probe", 0);
+    return failed;
+  }
+
+  /// Every split of 1 to 18 words between the vectors and the scalar
+  /// tail, with and without padding in the last word.
+  template <usize...NN>
+  usize check_all_bits() {
+    return (check_bits<NN>() + ...);
+  }
+
+  int check() {
+    const usize failed = check_all_bits<
+      1, 63, 64, 65, 127, 128, 129, 255, 256, 257,
+      511, 512, 513, 575, 576, 767, 1024, 1087>();
+    std::fprintf(stderr, "%zu failures.\n", failed);
+    return failed ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Driver
+//======================================================================//
+
+namespace {
+  bool parse_args(int argc, char** argv, Options& O) {
+    for (int Ix = 1; Ix < argc; ++Ix) {
+      const char* arg = argv[Ix];
+      if (std::strcmp(arg, "--check") == 0) {
+        O.check = true;
+        continue;
+      }
+      const char* val = (Ix + 1 < argc) ? argv[Ix + 1] : nullptr;
+      if (!val) {
+        std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+        return false;
+      }
+      if (std::strcmp(arg, "--out") == 0)
+        O.out = val;
+      else if (std::strcmp(arg, "--reps") == 0)
+        O.reps = u32(std::strtoul(val, nullptr, 0));
+      else {
+        std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+        return false;
+      }
+      ++Ix;
+    }
+    if (O.reps == 0)
+      O.reps = 1;
+    return true;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  Options O {};
+  if (!parse_args(argc, argv, O))
+    return 1;
+  if (O.check)
+    return check();
+  if (O.out && !(__out_ = std::fopen(O.out, "w"))) {
+    std::fprintf(stderr, "Unable to open '%s'.\n", O.out);
+    return 1;
+  }
+
+  __keys_.init();
+  auto* samples = static_cast<double*>(
+    std::malloc(sizeof(double) * O.reps));
+  std::fprintf(__out_, "bench,container,entries,median_cycles,p99_cycles\n");
+  const bool ok = run_keys<u64>("int", O, samples)
+               && run_keys<com::StrRef>("str", O, samples);
+
+  std::free(samples);
+  if (__out_ != stdout)
+    std::fclose(__out_);
+  return ok ? 0 : 1;
+}
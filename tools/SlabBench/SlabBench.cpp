@@ -0,0 +1,374 @@
+//===- SlabBench.cpp ------------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Host benchmark for the slab allocator behind `Box`, against the host
+//  `malloc`. Every thread allocates a window of 64 objects and frees
+//  them again, for each size class and 1 to 8 threads. The slab rows
+//  take the shared locks on every call, the cache rows go through a
+//  `SlabCache` per thread like `box_heap_alloc`. Pages come from `mmap`.
+//  Sizes past the classes are timed too, these map a block each time.
+//  Results are written as CSV, in reference cycles per allocation and
+//  free across all threads.
+//
+//  With `--check`, it instead tests the chunked `Arena` on the same
+//  pages: alignment, sizes that would wrap, rewinding to marks across
+//  chunks, and reusing the kept chunks after `reset()`.
+//
+//  Usage: hc-slab-bench [--reps <n>] [--out <file>]
+//         hc-slab-bench --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <Pages.hpp>
+
+#include <Common/Arena.hpp>
+#include <Common/SlabAllocator.hpp>
+
+using namespace hc;
+
+namespace {
+  constexpr u32 kThreadCounts[] { 1, 2, 4, 8 };
+  constexpr usize kLive = 64;
+  constexpr usize kRounds = 1024;
+  /// Every large allocation is a syscall, so fewer rounds.
+  constexpr usize kLargeRounds = 64;
+  constexpr usize kLargeSizes[] { 8192, 65536 };
+
+  struct Options {
+    const char* out = nullptr;
+    u32 reps = 15;
+    bool check = false;
+  };
+
+  FILE* __out_ = stdout;
+
+  void emit(const char* allocator, usize size,
+   u32 threads, bench::Stats cycles) {
+    std::fprintf(__out_, "%s,%zu,%u,%.2f,%.2f\n",
+      allocator, size, threads, cycles.median, cycles.p99);
+  }
+
+  struct MallocHeap {
+    void* allocate(usize size) { return std::malloc(size); }
+    void deallocate(void* P) { std::free(P); }
+  };
+} // namespace `anonymous`
+
+//======================================================================//
+// Churn
+//======================================================================//
+
+namespace {
+  /// Tags each object with its owner, so overlapping blocks are caught.
+  __always_inline usize tag_of(u32 tid, usize Ix) {
+    return (usize(tid) << 32) | Ix;
+  }
+
+  /// @return The number of failed or overlapping allocations.
+  template <typename Heap>
+  usize churn(Heap& H, usize size, usize rounds, u32 tid) {
+    void* live[kLive];
+    usize bad = 0;
+    for (usize R = 0; R < rounds; ++R) {
+      for (usize Ix = 0; Ix < kLive; ++Ix) {
+        auto* const P = static_cast<usize*>(H.allocate(size));
+        if (P)
+          *P = tag_of(tid, Ix);
+        live[Ix] = P;
+      }
+      for (usize Ix = 0; Ix < kLive; ++Ix) {
+        auto* const P = static_cast<usize*>(live[Ix]);
+        bad += usize(!P || *P != tag_of(tid, Ix));
+        H.deallocate(P);
+      }
+    }
+    return bad;
+  }
+
+  /// @return Cycles per allocation, or a zero median on failure.
+  template <typename F>
+  bench::Stats time_churn(F& per_thread, usize ops,
+   u32 threads, u32 reps, double* samples) {
+    for (u32 R = 0; R < reps; ++R) {
+      usize bad = 0;
+      auto pass = [&per_thread, &bad](u32 tid) {
+        __atomic_fetch_add(&bad, per_thread(tid), __ATOMIC_RELAXED);
+      };
+      const u64 cycles = bench::run_threads(threads, pass);
+      if (cycles == 0 || bad != 0) {
+        std::fprintf(stderr, "%zu bad allocations with %u threads.\n",
+          bad, threads);
+        return {};
+      }
+      samples[R] = double(cycles) / double(ops * threads);
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  bool run_size(com::SlabAllocator& heap, usize size,
+   const Options& O, double* samples) {
+    const usize rounds = (size > com::SlabAllocator::maxSmallSize)
+      ? kLargeRounds : kRounds;
+    const usize ops = kLive * rounds;
+    auto with_malloc = [size, rounds](u32 tid) {
+      MallocHeap H {};
+      return churn(H, size, rounds, tid);
+    };
+    auto with_slab = [&heap, size, rounds](u32 tid) {
+      return churn(heap, size, rounds, tid);
+    };
+    auto with_cache = [&heap, size, rounds](u32 tid) {
+      // Flushed when the thread is done, like a thread exiting.
+      com::SlabCache C {heap};
+      return churn(C, size, rounds, tid);
+    };
+
+    for (u32 threads : kThreadCounts) {
+      const auto M = time_churn(with_malloc, ops, threads, O.reps, samples);
+      if (M.median == 0.0)
+        return false;
+      emit("malloc", size, threads, M);
+      const auto S = time_churn(with_slab, ops, threads, O.reps, samples);
+      if (S.median == 0.0)
+        return false;
+      emit("slab", size, threads, S);
+      const auto C = time_churn(with_cache, ops, threads, O.reps, samples);
+      if (C.median == 0.0)
+        return false;
+      emit("cache", size, threads, C);
+    }
+    return true;
+  }
+
+  bool run_all_sizes(const Options& O, double* samples) {
+    com::SlabAllocator heap {bench::mmap_pages()};
+    for (usize cls = 0; cls < com::SlabAllocator::classCount; ++cls) {
+      const usize size = com::SlabAllocator::SizeOfClass(cls);
+      if (!run_size(heap, size, O, samples))
+        return false;
+    }
+    for (usize size : kLargeSizes) {
+      if (!run_size(heap, size, O, samples))
+        return false;
+    }
+    return true;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Arena
+//======================================================================//
+
+namespace {
+  /// Big enough that the checks span several chunks.
+  constexpr usize kArenaBlocks = 64;
+  constexpr usize kArenaBlockSize = 8192 - 24;
+
+  usize __maps_ = 0;
+  usize __unmaps_ = 0;
+
+  /// Counts the chunks, so reuse can be told apart from new pages.
+  com::AddrRange counted_map(usize min_size) {
+    ++__maps_;
+    return bench::__map_pages(min_size);
+  }
+
+  void counted_unmap(com::AddrRange pages) {
+    ++__unmaps_;
+    bench::__unmap_pages(pages);
+  }
+
+  /// Smaller than a chunk, so the arena spills early.
+  alignas(64) u8 __initial_[4096];
+
+  struct ArenaCheck {
+    usize failures = 0;
+  public:
+    void expect(bool ok, const char* what) {
+      if __expect_true(ok)
+        return;
+      ++failures;
+      std::fprintf(stderr, "arena: %s.\n", what);
+    }
+
+    static com::AddrRange Initial() {
+      return com::AddrRange::New(__initial_, sizeof(__initial_));
+    }
+
+    static com::PageProvider Pages() {
+      return {&counted_map, &counted_unmap};
+    }
+  };
+
+  void check_arena_alloc(ArenaCheck& R) {
+    com::Arena A {ArenaCheck::Initial(), ArenaCheck::Pages()};
+    u8* blocks[kArenaBlocks];
+    usize sizes[kArenaBlocks];
+    // Every alignment up to 4 KiB, tagged so overlaps show.
+    for (usize Ix = 0; Ix < kArenaBlocks; ++Ix) {
+      const usize size = 1 + (Ix * 97) % 3000;
+      const usize align = usize(1) << (Ix % 13);
+      auto* const P = static_cast<u8*>(A.allocate(size, align));
+      R.expect(P != nullptr, "allocation failed");
+      R.expect(uptr(P) % align == 0, "block is misaligned");
+      if (P)
+        std::memset(P, int(Ix), size);
+      blocks[Ix] = P;
+      sizes[Ix] = size;
+    }
+    for (usize Ix = 0; Ix < kArenaBlocks; ++Ix) {
+      for (usize Bx = 0; blocks[Ix] && Bx < sizes[Ix]; ++Bx) {
+        if (blocks[Ix][Bx] != u8(Ix)) {
+          R.expect(false, "blocks overlap");
+          break;
+        }
+      }
+    }
+    // Would wrap past the end of the chunk.
+    R.expect(A.allocate(Max<usize>, 1) == nullptr,
+      "allocated Max<usize> bytes");
+    R.expect(A.allocate(Max<usize> - 15, 16) == nullptr,
+      "allocated Max<usize> - 15 bytes");
+    R.expect(A.allocate<u64>(Max<usize> / 4).isEmpty(),
+      "allocated Max<usize> / 4 u64s");
+    R.expect(A.allocate(16, 16) != nullptr, "unusable after a failure");
+  }
+
+  void check_arena_rewind(ArenaCheck& R) {
+    com::Arena A {ArenaCheck::Initial(), ArenaCheck::Pages()};
+    const usize maps = __maps_;
+    (void) A.allocate(100, 8);
+    // From the initial buffer, into the pages.
+    const auto M = A.mark();
+    void* const first = A.allocate(kArenaBlockSize, 16);
+    for (usize Ix = 1; Ix < kArenaBlocks; ++Ix)
+      (void) A.allocate(kArenaBlockSize, 16);
+    const usize spilled = __maps_;
+    R.expect(spilled - maps >= 2, "spanned less than 2 chunks");
+    A.rewindTo(M);
+    R.expect(A.allocate(kArenaBlockSize, 16) == first,
+      "rewinding to the initial buffer");
+
+    // Within the pages, past a chunk boundary.
+    for (usize Ix = 1; Ix < kArenaBlocks / 2; ++Ix)
+      (void) A.allocate(kArenaBlockSize, 16);
+    const auto M2 = A.mark();
+    void* const second = A.allocate(kArenaBlockSize, 16);
+    for (usize Ix = 0; Ix < kArenaBlocks / 2; ++Ix)
+      (void) A.allocate(kArenaBlockSize, 16);
+    A.rewindTo(M2);
+    R.expect(A.allocate(kArenaBlockSize, 16) == second,
+      "rewinding to a chunk");
+    // Still within the chunks from the first pass.
+
+    const auto M3 = A.mark();
+    {
+      com::ArenaScope S {A};
+      for (usize Ix = 0; Ix < kArenaBlocks / 2; ++Ix)
+        (void) A.allocate(kArenaBlockSize, 16);
+    }
+    const auto after = A.mark();
+    R.expect(after.chunk == M3.chunk && after.offset == M3.offset,
+      "ArenaScope didn't rewind");
+    R.expect(__maps_ == spilled, "rewinding mapped more pages");
+  }
+
+  void check_arena_reset(ArenaCheck& R) {
+    com::Arena A {ArenaCheck::Initial(), ArenaCheck::Pages()};
+    void* first[kArenaBlocks];
+    for (usize Ix = 0; Ix < kArenaBlocks; ++Ix)
+      first[Ix] = A.allocate(kArenaBlockSize, 16);
+    const usize maps = __maps_;
+    A.reset();
+    // The kept chunks are walked in the same order.
+    for (usize Ix = 0; Ix < kArenaBlocks; ++Ix) {
+      if (A.allocate(kArenaBlockSize, 16) != first[Ix]) {
+        R.expect(false, "reset didn't reuse the chunks");
+        break;
+      }
+    }
+    R.expect(__maps_ == maps, "reset mapped more pages");
+  }
+
+  int check() {
+    ArenaCheck R {};
+    check_arena_alloc(R);
+    check_arena_rewind(R);
+    check_arena_reset(R);
+    R.expect(__maps_ == __unmaps_, "chunks were leaked");
+    std::fprintf(stderr, "%zu chunks, %zu failures.\n",
+      __maps_, R.failures);
+    return R.failures ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Driver
+//======================================================================//
+
+namespace {
+  bool parse_args(int argc, char** argv, Options& O) {
+    for (int Ix = 1; Ix < argc; ++Ix) {
+      const char* arg = argv[Ix];
+      if (std::strcmp(arg, "--check") == 0) {
+        O.check = true;
+        continue;
+      }
+      const char* val = (Ix + 1 < argc) ? argv[Ix + 1] : nullptr;
+      if (!val) {
+        std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+        return false;
+      }
+      if (std::strcmp(arg, "--out") == 0)
+        O.out = val;
+      else if (std::strcmp(arg, "--reps") == 0)
+        O.reps = u32(std::strtoul(val, nullptr, 0));
+      else {
+        std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+        return false;
+      }
+      ++Ix;
+    }
+    if (O.reps == 0)
+      O.reps = 1;
+    return true;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  Options O {};
+  if (!parse_args(argc, argv, O))
+    return 1;
+  if (O.check)
+    return check();
+  if (O.out && !(__out_ = std::fopen(O.out, "w"))) {
+    std::fprintf(stderr, "Unable to open '%s'.\n", O.out);
+    return 1;
+  }
+
+  auto* samples = static_cast<double*>(
+    std::malloc(sizeof(double) * O.reps));
+  std::fprintf(__out_, "allocator,size,threads,median_cycles,p99_cycles\n");
+  const bool ok = run_all_sizes(O, samples);
+
+  std::free(samples);
+  if (__out_ != stdout)
+    std::fclose(__out_);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,511 @@
+//===- StrTblBench.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Host benchmark for the string tables. Lookups are timed over 1k,
+//  10k and 60k identifier-like strings, half of them misses, in the
+//  sorted, accelerated and hashed tables, and batched through
+//  `locateMany` on the sorted table. Inserting the same strings into
+//  an empty table is timed plain, kept sorted and hashed. Sorting is
+//  timed from insertion order with the sorter the tool was built with,
+//  so each sorter has its own executable. Results are written as CSV.
+//
+//  With `--check`, it instead fills a wide table past 4MiB and checks
+//  every string survives insertion, sorting and lookup, with and
+//  without the search accelerator. Narrow and wide tables are also
+//  round-tripped through `freeze`, checking every string and misses.
+//
+//  Usage: hc-strtbl-bench [--reps <n>] [--out <file>]
+//         hc-strtbl-bench --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <Bench.hpp>
+
+#include <Parcel/FrozenStringTable.hpp>
+#include <Parcel/StringTable.hpp>
+
+using namespace hc;
+using namespace hc::parcel;
+
+namespace {
+  constexpr usize kMaxStrings = 60000;
+  constexpr usize kBufSize    = usize(1) << 20;
+  constexpr usize kTblSize    = 65536;
+  constexpr usize kHashSlots  = 131072;
+  constexpr usize kQueries    = 4096;
+  constexpr usize kCounts[] { 1000, 10000, 60000 };
+
+  struct Options {
+    const char* out = nullptr;
+    u32 reps = 31;
+    bool check = false;
+  };
+
+  /// Exposes the lookups, which are only used by derived tables.
+  template <usize BufSize, usize TblSize, usize HashSlots = 0>
+  struct BenchTable : BasicStringTable<u32, BufSize, TblSize, HashSlots> {
+    using BasicIStringTable<u32>::locateString;
+  };
+
+  using SortedTable = BenchTable<kBufSize, kTblSize>;
+  using HashedTable = BenchTable<kBufSize, kTblSize, kHashSlots>;
+
+#if _HC_RADIX_STRING_TABLE
+  constexpr const char* kSorter = "radix";
+#elif _HC_FAST_STRING_TABLE
+  constexpr const char* kSorter = "introsort";
+#else
+  constexpr const char* kSorter = "insertion";
+#endif
+} // namespace `anonymous`
+
+//======================================================================//
+// Strings
+//======================================================================//
+
+namespace {
+  /// Identifier-like strings, between 4 and 27 characters.
+  struct StringSet {
+    static constexpr usize kMaxLen = 27;
+    char data[kMaxStrings * (kMaxLen + 1)] {};
+    com::StrRef strs[kMaxStrings] {};
+    /// Mutated copies of `strs`, which shouldn't be found.
+    char missData[kMaxStrings * (kMaxLen + 1)] {};
+    com::StrRef misses[kMaxStrings] {};
+  public:
+    /// Deterministic, so runs can be compared.
+    void init() {
+      static constexpr char kChars[]
+        = "abcdefghijklmnopqrstuvwxyz"
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+      u64 state = 0x9E3779B97F4A7C15ULL;
+      auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+      };
+      char* P = data;
+      char* M = missData;
+      for (usize Ix = 0; Ix < kMaxStrings; ++Ix) {
+        const usize len = 4 + (next() % (kMaxLen - 3));
+        for (usize Cx = 0; Cx < len; ++Cx)
+          P[Cx] = kChars[next() % (sizeof(kChars) - 1)];
+        std::memcpy(M, P, len);
+        // Digits are never the last character of a hit.
+        P[len - 1] = char('a' + (next() % 26));
+        M[len - 1] = char('0' + (next() % 10));
+        strs[Ix] = com::StrRef::New(P, len);
+        misses[Ix] = com::StrRef::New(M, len);
+        P += len + 1;
+        M += len + 1;
+      }
+    }
+  };
+
+  StringSet __strings_ {};
+
+  /// Alternates hits and misses from the first `count` strings.
+  void make_queries(com::StrRef* out, usize count) {
+    u64 state = 0x2545F4914F6CDD1DULL;
+    for (usize Ix = 0; Ix < kQueries; ++Ix) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      const usize Sx = usize(state % count);
+      out[Ix] = (Ix & 1) ? __strings_.misses[Sx] : __strings_.strs[Sx];
+    }
+  }
+
+  template <typename TableType>
+  bool fill(TableType& T, usize count) {
+    T->clear();
+    for (usize Ix = 0; Ix < count; ++Ix) {
+      const auto R = T->insert(__strings_.strs[Ix]);
+      if (R.u == TableType::BaseType::Status::atCapacity)
+        return false;
+    }
+    return true;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Lookups
+//======================================================================//
+
+namespace {
+  FILE* __out_ = stdout;
+
+  void emit(const char* bench, const char* table,
+   usize strings, bench::Stats cycles) {
+    std::fprintf(__out_, "%s,%s,%zu,%.2f,%.2f\n",
+      bench, table, strings, cycles.median, cycles.p99);
+  }
+
+  /// @return Cycles per lookup.
+  template <typename TableType>
+  bench::Stats time_lookups(const TableType& T,
+   const com::StrRef* queries, u32 reps, double* samples) {
+    return bench::measure([&] {
+      usize found = 0;
+      for (usize Ix = 0; Ix < kQueries; ++Ix)
+        found += T.locateString(queries[Ix]).size();
+      bench::consume(found);
+    }, reps, double(kQueries), samples);
+  }
+
+  /// @return Cycles per lookup, resolving every query in one batch.
+  template <typename TableType>
+  bench::Stats time_batch(const TableType& T,
+   const com::StrRef* queries, u32 reps, double* samples) {
+    static com::StrRef out[kQueries];
+    const auto keys = com::ImmPtrRange<com::StrRef>::New(queries, kQueries);
+    return bench::measure([&] {
+      const usize found = T->locateMany(keys,
+        com::PtrRange<com::StrRef>::New(out));
+      bench::consume(found);
+    }, reps, double(kQueries), samples);
+  }
+
+  bool run_lookups(const Options& O, double* samples) {
+    static SortedTable sorted {};
+    static SortedTable accel {};
+    static HashedTable hashed {};
+    static StrTblSearchKey keys[kTblSize + 1];
+    static com::StrRef queries[kQueries];
+    accel->attachSearchAccelerator(com::PtrRange<StrTblSearchKey>::New(keys));
+    for (usize count : kCounts) {
+      if (!fill(sorted, count) || !fill(accel, count)
+       || !fill(hashed, count)) {
+        std::fprintf(stderr, "Unable to fit %zu strings.\n", count);
+        return false;
+      }
+      sorted->shortlexSort();
+      accel->shortlexSort();
+      make_queries(queries, count);
+      emit("lookup", "sorted", count,
+        time_lookups(sorted, queries, O.reps, samples));
+      emit("lookup", "batch", count,
+        time_batch(sorted, queries, O.reps, samples));
+      emit("lookup", "accel", count,
+        time_lookups(accel, queries, O.reps, samples));
+      emit("lookup", "hashed", count,
+        time_lookups(hashed, queries, O.reps, samples));
+    }
+    return true;
+  }
+
+  /// @return Cycles per string, inserting into an empty table each time.
+  template <typename TableType>
+  bench::Stats time_inserts(TableType& T, bool ksorted,
+   usize count, u32 reps, double* samples) {
+    using Status = typename TableType::BaseType::Status;
+    for (u32 R = 0; R < reps; ++R) {
+      T->clear();
+      (void) T->setKSortPolicy(ksorted);
+      usize failed = 0;
+      const u64 start = bench::now();
+      for (usize Ix = 0; Ix < count; ++Ix)
+        failed += (T->insert(__strings_.strs[Ix]).u == Status::atCapacity);
+      samples[R] = double(bench::now() - start) / double(count);
+      if (failed != 0)
+        return {};
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  bool run_inserts(const Options& O, double* samples) {
+    static SortedTable plain {};
+    static SortedTable ksorted {};
+    static HashedTable hashed {};
+    for (usize count : kCounts) {
+      // Sorted inserts shift the table, keep 60k from taking minutes.
+      const u32 reps = (count >= 10000 && O.reps > 5) ? 5 : O.reps;
+      const auto P = time_inserts(plain, false, count, O.reps, samples);
+      const auto K = time_inserts(ksorted, true, count, reps, samples);
+      const auto H = time_inserts(hashed, false, count, O.reps, samples);
+      if (P.median == 0.0 || K.median == 0.0 || H.median == 0.0) {
+        std::fprintf(stderr, "Unable to fit %zu strings.\n", count);
+        return false;
+      }
+      emit("insert", "append", count, P);
+      emit("insert", "ksorted", count, K);
+      emit("insert", "hashed", count, H);
+    }
+    return true;
+  }
+
+  /// @return Cycles per string, sorting from insertion order each time.
+  bench::Stats time_sort(SortedTable& T,
+   usize count, u32 reps, double* samples) {
+    for (u32 R = 0; R < reps; ++R) {
+      T->unsort();
+      const u64 start = bench::now();
+      T->shortlexSort();
+      samples[R] = double(bench::now() - start) / double(count);
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  bool run_sorts(const Options& O, double* samples) {
+    static SortedTable T {};
+    for (usize count : kCounts) {
+      if (!fill(T, count)) {
+        std::fprintf(stderr, "Unable to fit %zu strings.\n", count);
+        return false;
+      }
+      // The insertion sorter is quadratic, keep it from taking minutes.
+      const u32 reps = (count >= 10000 && O.reps > 5) ? 5 : O.reps;
+      emit("sort", kSorter, count, time_sort(T, count, reps, samples));
+    }
+    return true;
+  }
+
+  bool parse_args(int argc, char** argv, Options& O) {
+    for (int Ix = 1; Ix < argc; ++Ix) {
+      const char* arg = argv[Ix];
+      if (std::strcmp(arg, "--check") == 0) {
+        O.check = true;
+        continue;
+      }
+      const char* val = (Ix + 1 < argc) ? argv[Ix + 1] : nullptr;
+      if (!val) {
+        std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+        return false;
+      }
+      if (std::strcmp(arg, "--out") == 0)
+        O.out = val;
+      else if (std::strcmp(arg, "--reps") == 0)
+        O.reps = u32(std::strtoul(val, nullptr, 0));
+      else {
+        std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+        return false;
+      }
+      ++Ix;
+    }
+    if (O.reps == 0)
+      O.reps = 1;
+    return true;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Checking
+//======================================================================//
+
+namespace {
+  constexpr usize kWideStrings = 320000;
+  constexpr usize kWideBufSize = usize(8) << 20;
+  /// Well past what a 16-bit offset can address.
+  constexpr usize kWideMinBytes = usize(4) << 20;
+
+  using WideTable = BenchTable<kWideBufSize, kWideStrings>;
+
+  /// Unique, since the index is spelled out in the first 6 characters.
+  usize make_wide_string(usize Ix, char* out) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    for (usize Cx = 0; Cx < 6; ++Cx)
+      out[Cx] = kHex[(Ix >> (Cx * 4)) & 0xF];
+    const usize len = 8 + (Ix * 7) % 17;
+    for (usize Cx = 6; Cx < len; ++Cx)
+      out[Cx] = char('a' + ((Ix + Cx * 3) % 26));
+    return len;
+  }
+
+  u32 locate_all(const WideTable& T, const char* table) {
+    char S[32];
+    u32 failed = 0;
+    for (usize Ix = 0; Ix < kWideStrings; ++Ix) {
+      const auto str = com::StrRef::New(S, make_wide_string(Ix, S));
+      if (!T.locateString(str).isEqual(str)) {
+        std::fprintf(stderr, "String %zu wasn't found %s.\n", Ix, table);
+        ++failed;
+      }
+    }
+    return failed;
+  }
+
+  u32 check_wide_table() {
+    static WideTable T {};
+    static StrTblSearchKey keys[kWideStrings + 1];
+    char S[32];
+    u32 failed = 0;
+    for (usize Ix = 0; Ix < kWideStrings; ++Ix) {
+      const auto str = com::StrRef::New(S, make_wide_string(Ix, S));
+      const auto R = T->insert(str);
+      if (R.u != WideTable::BaseType::Status::success) {
+        std::fprintf(stderr, "Insert %zu failed.\n", Ix);
+        return failed + 1;
+      }
+    }
+    if (T->sizeInBytes() < kWideMinBytes) {
+      std::fprintf(stderr, "Only %zu bytes were used.\n", T->sizeInBytes());
+      ++failed;
+    }
+
+    // Insertion order, through offsets past 64KiB.
+    usize Ix = 0;
+    for (const com::StrRef tblS : T) {
+      const auto str = com::StrRef::New(S, make_wide_string(Ix, S));
+      if (!tblS.isEqual(str)) {
+        std::fprintf(stderr, "String %zu was corrupted.\n", Ix);
+        ++failed;
+      }
+      ++Ix;
+    }
+    if (Ix != kWideStrings) {
+      std::fprintf(stderr, "Iterated %zu strings.\n", Ix);
+      ++failed;
+    }
+
+    T->shortlexSort();
+    failed += locate_all(T, "sorted");
+    // Every string is longer than 8, so each hit takes the full compare.
+    T->attachSearchAccelerator(com::PtrRange<StrTblSearchKey>::New(keys));
+    failed += locate_all(T, "accelerated");
+    return failed;
+  }
+
+  /// Long runs of shared characters, so most entries are front-coded.
+  /// Some are past 127 bytes, so their lengths take 2 bytes. Unique,
+  /// since the index is spelled out in the last 6 characters.
+  usize make_frozen_string(usize Ix, char* out) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    const usize len = 7 + (Ix * 37) % 190;
+    for (usize Cx = 0; Cx < len - 6; ++Cx)
+      out[Cx] = char('a' + ((Cx / 8) + (Ix % 3)) % 26);
+    for (usize Cx = 0; Cx < 6; ++Cx)
+      out[len - 6 + Cx] = kHex[(Ix >> (Cx * 4)) & 0xF];
+    return len;
+  }
+
+  template <typename TableType>
+  u32 check_frozen(TableType& T, usize count, const char* table) {
+    static u8 image[usize(2) << 20];
+    char S[256];
+    char out[256];
+    u32 failed = 0;
+    T->clear();
+    for (usize Ix = 0; Ix < count; ++Ix) {
+      const auto str = com::StrRef::New(S, make_frozen_string(Ix, S));
+      if (T->insert(str).u != TableType::BaseType::Status::success) {
+        std::fprintf(stderr, "Insert %zu failed (%s).\n", Ix, table);
+        return 1;
+      }
+    }
+    T->shortlexSort();
+
+    const usize size = T->freeze(com::PtrRange<u8>::New(nullptr, usize(0)));
+    if (size == 0 || size > sizeof(image)
+     || T->freeze(com::PtrRange<u8>::New(image, size)) != size) {
+      std::fprintf(stderr, "Unable to freeze %zu strings (%s).\n",
+        count, table);
+      return 1;
+    }
+    const auto F = FrozenStringTable::New(
+      com::ImmAddrRange::New(image, size));
+    if (!F.isValid() || F.size() != count) {
+      std::fprintf(stderr, "Frozen table has %zu of %zu strings (%s).\n",
+        F.size(), count, table);
+      return 1;
+    }
+
+    // Every string should be at its sorted position.
+    usize Ix = 0;
+    for (const com::StrRef tblS : T) {
+      const auto outS = F.resolveAt(Ix, com::PtrRange<char>::New(out));
+      const isize found = F.indexOf(tblS);
+      if (!outS.isEqual(tblS) || found != isize(Ix)) {
+        std::fprintf(stderr, "String %zu was found at %zd (%s).\n",
+          Ix, found, table);
+        ++failed;
+      }
+      ++Ix;
+    }
+
+    // Changes the last character to one outside the hex digits.
+    for (usize Mx = 0; Mx < count; ++Mx) {
+      const usize len = make_frozen_string(Mx, S);
+      S[len - 1] = 'x';
+      if (F.indexOf(com::StrRef::New(S, len)) >= 0) {
+        std::fprintf(stderr, "Miss %zu was found (%s).\n", Mx, table);
+        ++failed;
+      }
+    }
+    const usize max_len = F.maxLength();
+    std::memset(S, 'a', sizeof(S));
+    if (F.indexOf(com::StrRef::New(S, max_len + 1)) >= 0
+     || F.indexOf(com::StrRef::New(S, usize(1))) >= 0
+     || F.resolveAt(count, com::PtrRange<char>::New(out)).data()) {
+      std::fprintf(stderr, "Out of range lookups succeeded (%s).\n", table);
+      ++failed;
+    }
+
+    // A bad magic number should be rejected.
+    image[0] ^= 0xFF;
+    if (FrozenStringTable::New(
+        com::ImmAddrRange::New(image, size)).isValid()) {
+      std::fprintf(stderr, "A corrupt image was accepted (%s).\n", table);
+      ++failed;
+    }
+    return failed;
+  }
+
+  u32 check_frozen_tables() {
+    // Counts on either side of a full bucket.
+    static BasicStringTable<u16, 60000, 512> narrow {};
+    static BasicStringTable<u32, kWideBufSize, 8192> wide {};
+    return check_frozen(narrow, 0, "narrow")
+         + check_frozen(narrow, 1, "narrow")
+         + check_frozen(narrow, 256, "narrow")
+         + check_frozen(narrow, 500, "narrow")
+         + check_frozen(wide, 5003, "wide");
+  }
+
+  int check() {
+    const u32 failed = check_wide_table() + check_frozen_tables();
+    std::fprintf(stderr, "%u failures.\n", failed);
+    return failed ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  Options O {};
+  if (!parse_args(argc, argv, O))
+    return 1;
+  if (O.check)
+    return check();
+  if (O.out && !(__out_ = std::fopen(O.out, "w"))) {
+    std::fprintf(stderr, "Unable to open '%s'.\n", O.out);
+    return 1;
+  }
+
+  __strings_.init();
+  auto* samples = static_cast<double*>(
+    std::malloc(sizeof(double) * O.reps));
+  std::fprintf(__out_, "bench,table,strings,median_cycles,p99_cycles\n");
+  const bool ok = run_lookups(O, samples)
+               && run_inserts(O, samples)
+               && run_sorts(O, samples);
+
+  std::free(samples);
+  if (__out_ != stdout)
+    std::fclose(__out_);
+  return ok ? 0 : 1;
+}
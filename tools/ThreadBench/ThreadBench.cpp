@@ -0,0 +1,482 @@
+//===- ThreadBench.cpp ----------------------------------------------===//
+//
+// Copyright (C) 2024 Eightfold
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+//     limitations under the License.
+//
+//===----------------------------------------------------------------===//
+//
+//  Host benchmark for the concurrent structures, swept over 1 to 8
+//  threads. The sharded string table is timed with every thread
+//  interning the same strings in a different order, so the first pass
+//  over each string inserts and the rest find it. The rings are timed
+//  passing 1M items, with the threads split between producers and
+//  consumers. A single thread alternates pushing and popping. Results
+//  are written as CSV, in reference cycles per operation or item.
+//
+//  With `--check`, it instead stress tests `AtomicSkiplist`, checking
+//  no slot is ever held by two threads at once.
+//
+//  Usage: hc-thread-bench [--reps <n>] [--out <file>]
+//         hc-thread-bench --check
+//
+//===----------------------------------------------------------------===//
+
+// The host headers go first, the runtime finalizes some of their macros.
+#include <Threads.hpp>
+
+#include <Common/Lifetime.hpp>
+#include <Parcel/AtomicSkiplist.hpp>
+#include <Parcel/ConcurrentStringTable.hpp>
+#include <Parcel/Ring.hpp>
+
+using namespace hc;
+using namespace hc::parcel;
+
+namespace {
+  constexpr u32 kThreadCounts[] { 1, 2, 4, 6, 8 };
+
+  struct Options {
+    const char* out = nullptr;
+    u32 reps = 15;
+    bool check = false;
+  };
+
+  FILE* __out_ = stdout;
+
+  void emit(const char* bench, usize variant,
+   u32 threads, bench::Stats cycles) {
+    std::fprintf(__out_, "%s,%zu,%u,%.2f,%.2f\n",
+      bench, variant, threads, cycles.median, cycles.p99);
+  }
+
+  /// Constructs `T` in fresh storage, since most tables can't be reset.
+  template <typename T>
+  T* make_fresh() {
+    void* const P = bench::aligned_alloc(alignof(T), sizeof(T));
+    return P ? com::construct_at(static_cast<T*>(P)) : nullptr;
+  }
+
+  template <typename T>
+  void free_fresh(T* P) {
+    if (P)
+      P->~T();
+    bench::aligned_free(P);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Shards
+//======================================================================//
+
+namespace {
+  constexpr usize kStrings = 32768;
+  static_assert((kStrings & (kStrings - 1)) == 0);
+  /// Identifiers average 15.5 characters.
+  constexpr usize kStringBytes = kStrings * 16;
+
+  /// Identifier-like strings, between 4 and 27 characters.
+  struct StringSet {
+    static constexpr usize kMaxLen = 27;
+    char data[kStrings * (kMaxLen + 1)] {};
+    com::StrRef strs[kStrings] {};
+  public:
+    /// Deterministic, so runs can be compared.
+    void init() {
+      static constexpr char kChars[]
+        = "abcdefghijklmnopqrstuvwxyz"
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+      static constexpr char kHex[] = "0123456789abcdef";
+      u64 state = 0x9E3779B97F4A7C15ULL;
+      auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+      };
+      char* P = data;
+      for (usize Ix = 0; Ix < kStrings; ++Ix) {
+        const usize len = 4 + (next() % (kMaxLen - 3));
+        for (usize Cx = 0; Cx < len; ++Cx)
+          P[Cx] = kChars[next() % (sizeof(kChars) - 1)];
+        // The index is spelled out in the first 4, so they're unique.
+        for (usize Cx = 0; Cx < 4; ++Cx)
+          P[Cx] = kHex[(Ix >> (Cx * 4)) & 0xF];
+        strs[Ix] = com::StrRef::New(P, len);
+        P += len + 1;
+      }
+    }
+  };
+
+  StringSet __strings_ {};
+
+  /// Twice the average load per shard, so skew never fills one.
+  template <usize Shards>
+  using ShardedTable = ConcurrentStringTable<Shards,
+    (kStringBytes * 2) / Shards, (kStrings * 2) / Shards>;
+
+  /// @return Cycles per intern, or a zero median on failure.
+  template <usize Shards>
+  bench::Stats time_shards(u32 threads, u32 reps, double* samples) {
+    using TableType = ShardedTable<Shards>;
+    for (u32 R = 0; R < reps; ++R) {
+      TableType* const T = make_fresh<TableType>();
+      if (!T)
+        return {};
+      auto intern = [T, threads](u32 tid) {
+        // Coprime with `kStrings`, so each thread visits every string.
+        const usize stride = 2 * tid + 1;
+        usize Sx = (kStrings / threads) * tid;
+        usize failed = 0;
+        for (usize Ix = 0; Ix < kStrings; ++Ix) {
+          const auto res = T->insert(__strings_.strs[Sx]);
+          failed += usize(res.t.isEmpty());
+          Sx = (Sx + stride) & (kStrings - 1);
+        }
+        bench::consume(failed);
+      };
+      const u64 cycles = bench::run_threads(threads, intern);
+      const usize interned = T->size();
+      free_fresh(T);
+      if (cycles == 0 || interned != kStrings) {
+        std::fprintf(stderr, "Interned %zu of %zu strings.\n",
+          interned, kStrings);
+        return {};
+      }
+      samples[R] = double(cycles) / double(kStrings * threads);
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  template <usize Shards>
+  bool run_shards(const Options& O, double* samples) {
+    for (u32 threads : kThreadCounts) {
+      const auto S = time_shards<Shards>(threads, O.reps, samples);
+      if (S.median == 0.0)
+        return false;
+      emit("shards", Shards, threads, S);
+    }
+    return true;
+  }
+
+  bool run_all_shards(const Options& O, double* samples) {
+    __strings_.init();
+    return run_shards<1>(O, samples)
+        && run_shards<4>(O, samples)
+        && run_shards<16>(O, samples)
+        && run_shards<64>(O, samples);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Rings
+//======================================================================//
+
+namespace {
+  constexpr usize kItems = usize(1) << 20;
+  /// The sum of `[1, kItems]`, every item is pushed once.
+  constexpr u64 kItemSum = u64(kItems) * (kItems + 1) / 2;
+
+  struct RingRun {
+    u32 producers = 0;
+    u32 done = 0;
+    u64 sum = 0;
+  };
+
+  /// Producer `tid` pushes every `producers`th item.
+  template <typename RingType>
+  void produce(RingType& ring, RingRun& run, u32 tid) {
+    for (usize V = tid + 1; V <= kItems; V += run.producers) {
+      while (!ring.push(V))
+        __builtin_ia32_pause();
+    }
+    __atomic_fetch_add(&run.done, 1, __ATOMIC_RELEASE);
+  }
+
+  /// Pops until every producer is done and the ring is empty.
+  template <typename RingType>
+  void consume(RingType& ring, RingRun& run) {
+    u64 sum = 0;
+    while (true) {
+      if (auto V = ring.pop(); V.isSome()) {
+        sum += V.some();
+        continue;
+      }
+      if (__atomic_load_n(&run.done, __ATOMIC_ACQUIRE) == run.producers) {
+        // Everything pushed is visible now, drain what's left.
+        for (auto V = ring.pop(); V.isSome(); V = ring.pop())
+          sum += V.some();
+        break;
+      }
+      __builtin_ia32_pause();
+    }
+    __atomic_fetch_add(&run.sum, sum, __ATOMIC_RELAXED);
+  }
+
+  /// Pushes and pops on one thread, with at most `burst` items queued.
+  template <typename RingType>
+  void alternate(RingType& ring, RingRun& run) {
+    constexpr usize burst = 32;
+    u64 sum = 0;
+    for (usize V = 1; V <= kItems;) {
+      for (usize Ix = 0; Ix < burst && V <= kItems; ++Ix, ++V)
+        (void) ring.push(V);
+      for (auto P = ring.pop(); P.isSome(); P = ring.pop())
+        sum += P.some();
+    }
+    run.sum = sum;
+  }
+
+  /// @return Cycles per item, or a zero median on failure.
+  template <typename RingType>
+  bench::Stats time_ring(u32 threads, u32 reps, double* samples) {
+    for (u32 R = 0; R < reps; ++R) {
+      RingType* const ring = make_fresh<RingType>();
+      if (!ring)
+        return {};
+      RingRun run {};
+      run.producers = (threads > 1) ? threads / 2 : 1;
+      auto pass = [ring, &run, threads](u32 tid) {
+        if (threads == 1)
+          alternate(*ring, run);
+        else if (tid < run.producers)
+          produce(*ring, run, tid);
+        else
+          consume(*ring, run);
+      };
+      const u64 cycles = bench::run_threads(threads, pass);
+      free_fresh(ring);
+      if (cycles == 0 || run.sum != kItemSum) {
+        std::fprintf(stderr, "Items were lost with %u threads.\n", threads);
+        return {};
+      }
+      samples[R] = double(cycles) / double(kItems);
+    }
+    return bench::summarize(samples, reps);
+  }
+
+  template <usize Slots>
+  bool run_rings(const Options& O, double* samples) {
+    using Spsc = SpscRing<u64, Slots>;
+    using Mpmc = MpmcRing<u64, Slots>;
+    // Only one producer and one consumer.
+    static constexpr u32 kSpscThreads[] {1, 2};
+    for (u32 threads : kSpscThreads) {
+      const auto S = time_ring<Spsc>(threads, O.reps, samples);
+      if (S.median == 0.0)
+        return false;
+      emit("spsc", Slots, threads, S);
+    }
+    for (u32 threads : kThreadCounts) {
+      const auto S = time_ring<Mpmc>(threads, O.reps, samples);
+      if (S.median == 0.0)
+        return false;
+      emit("mpmc", Slots, threads, S);
+    }
+    return true;
+  }
+
+  bool run_all_rings(const Options& O, double* samples) {
+    return run_rings<64>(O, samples)
+        && run_rings<1024>(O, samples);
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Checking
+//======================================================================//
+
+namespace {
+  /// Not a multiple of 64, so the padding bits are claimable if broken.
+  constexpr usize kSlots = 150;
+  constexpr u32 kStressThreads = 8;
+  constexpr usize kIterations = 200000;
+  /// About half are held at once, enough that the list is often full.
+  constexpr usize kHeld = 40;
+
+  u32 __lives_ = 0;
+
+  struct Slot {
+    Slot(u32 owner, u32 seq) : owner(owner), seq(seq) {
+      __atomic_fetch_add(&__lives_, 1, __ATOMIC_RELAXED);
+    }
+    ~Slot() {
+      __atomic_fetch_sub(&__lives_, 1, __ATOMIC_RELAXED);
+    }
+  public:
+    u32 owner;
+    u32 seq;
+  };
+
+  using StressList = AtomicSkiplist<Slot, kSlots>;
+
+  struct Stress {
+    StressList list {};
+    /// The thread holding each slot, plus one.
+    u32 holders[kSlots] {};
+    u32 failures = 0;
+    u64 claims = 0;
+    u64 full = 0;
+  public:
+    void fail(const char* what, usize slot, u32 tid) {
+      if (__atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED) < 16)
+        std::fprintf(stderr, "Thread %u: %s (slot %zu).\n", tid, what, slot);
+    }
+
+    void release(Slot* P, u32 tid, u32 seq) {
+      const usize V = usize(P - list.__data[0].data());
+      if (P->owner != tid || P->seq != seq)
+        this->fail("slot was overwritten", V, tid);
+      u32 expected = tid + 1;
+      if (!__atomic_compare_exchange_n(&holders[V], &expected, 0,
+          false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        this->fail("slot was shared", V, tid);
+      if (!list.eraseRaw(P))
+        this->fail("erase failed", V, tid);
+    }
+
+    void run(u32 tid) {
+      Slot* held[kHeld] {};
+      u32 seqs[kHeld] {};
+      u64 state = 0x9E3779B97F4A7C15ULL * (tid + 1);
+      u64 claims = 0, full = 0;
+      for (usize Ix = 0; Ix < kIterations; ++Ix) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const usize H = usize(state % kHeld);
+        if (held[H]) {
+          this->release(held[H], tid, seqs[H]);
+          held[H] = nullptr;
+          continue;
+        }
+        const u32 seq = u32(Ix);
+        Slot* const P = list.insertRaw(tid, seq);
+        if (!P) {
+          ++full;
+          continue;
+        }
+        const usize V = usize(P - list.__data[0].data());
+        if (V >= kSlots) {
+          this->fail("slot out of range", V, tid);
+          continue;
+        }
+        u32 expected = 0;
+        if (!__atomic_compare_exchange_n(&holders[V], &expected, tid + 1,
+            false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+          this->fail("slot was claimed twice", V, tid);
+        held[H] = P;
+        seqs[H] = seq;
+        ++claims;
+      }
+      for (usize H = 0; H < kHeld; ++H) {
+        if (held[H])
+          this->release(held[H], tid, seqs[H]);
+      }
+      __atomic_fetch_add(&this->claims, claims, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&this->full, full, __ATOMIC_RELAXED);
+    }
+  };
+
+  u32 check_skiplist() {
+    Stress* const S = make_fresh<Stress>();
+    if (!S)
+      return 1;
+    auto stress = [S](u32 tid) { S->run(tid); };
+    u32 failed = 0;
+    if (bench::run_threads(kStressThreads, stress) == 0) {
+      std::fprintf(stderr, "Unable to start the threads.\n");
+      ++failed;
+    }
+    failed += S->failures;
+    if (const usize active = S->list.countActive(); active != 0) {
+      std::fprintf(stderr, "%zu slots were left active.\n", active);
+      ++failed;
+    }
+    if (__lives_ != 0) {
+      std::fprintf(stderr, "%u slots were never destroyed.\n", __lives_);
+      ++failed;
+    }
+    // Without contention for a full list, the test proves little.
+    if (S->full == 0) {
+      std::fprintf(stderr, "The list was never full.\n");
+      ++failed;
+    }
+    std::fprintf(stderr, "%llu claims, %llu while full.\n",
+      (unsigned long long)S->claims, (unsigned long long)S->full);
+    free_fresh(S);
+    return failed;
+  }
+
+  int check() {
+    const u32 failed = check_skiplist();
+    std::fprintf(stderr, "%u failures.\n", failed);
+    return failed ? 1 : 0;
+  }
+} // namespace `anonymous`
+
+//======================================================================//
+// Driver
+//======================================================================//
+
+namespace {
+  bool parse_args(int argc, char** argv, Options& O) {
+    for (int Ix = 1; Ix < argc; ++Ix) {
+      const char* arg = argv[Ix];
+      if (std::strcmp(arg, "--check") == 0) {
+        O.check = true;
+        continue;
+      }
+      const char* val = (Ix + 1 < argc) ? argv[Ix + 1] : nullptr;
+      if (!val) {
+        std::fprintf(stderr, "Missing value for '%s'.\n", arg);
+        return false;
+      }
+      if (std::strcmp(arg, "--out") == 0)
+        O.out = val;
+      else if (std::strcmp(arg, "--reps") == 0)
+        O.reps = u32(std::strtoul(val, nullptr, 0));
+      else {
+        std::fprintf(stderr, "Unknown option '%s'.\n", arg);
+        return false;
+      }
+      ++Ix;
+    }
+    if (O.reps == 0)
+      O.reps = 1;
+    return true;
+  }
+} // namespace `anonymous`
+
+int main(int argc, char** argv) {
+  Options O {};
+  if (!parse_args(argc, argv, O))
+    return 1;
+  if (O.check)
+    return check();
+  if (O.out && !(__out_ = std::fopen(O.out, "w"))) {
+    std::fprintf(stderr, "Unable to open '%s'.\n", O.out);
+    return 1;
+  }
+
+  auto* samples = static_cast<double*>(
+    std::malloc(sizeof(double) * O.reps));
+  std::fprintf(__out_, "bench,variant,threads,median_cycles,p99_cycles\n");
+  const bool ok = run_all_shards(O, samples)
+               && run_all_rings(O, samples);
+
+  std::free(samples);
+  if (__out_ != stdout)
+    std::fclose(__out_);
+  return ok ? 0 : 1;
+}